@@ -0,0 +1,50 @@
+# Profile-guided optimization workflow, run in script mode by the 'pgo' target:
+#   1. configure and build instrumented engine
+#   2. run built-in bench as training workload
+#   3. rebuild engine using gathered profile
+# Final binary: ${BINARY_DIR}/USE/austerlitz
+
+foreach(var SOURCE_DIR BINARY_DIR CXX_COMPILER CXX_COMPILER_ID ARCH BENCH_DEPTH)
+	if(NOT DEFINED ${var})
+		message(FATAL_ERROR "PGO.cmake: ${var} not set")
+	endif()
+endforeach()
+
+set(profile_dir "${BINARY_DIR}/profile")
+file(REMOVE_RECURSE "${profile_dir}")
+file(MAKE_DIRECTORY "${profile_dir}")
+
+function(run_step)
+	execute_process(COMMAND ${ARGN} RESULT_VARIABLE res)
+	if(NOT res EQUAL 0)
+		message(FATAL_ERROR "PGO step failed: ${ARGN}")
+	endif()
+endfunction()
+
+function(build_stage stage)
+	run_step(${CMAKE_COMMAND} -S "${SOURCE_DIR}" -B "${BINARY_DIR}/${stage}"
+		-DCMAKE_BUILD_TYPE=Release
+		-DCMAKE_CXX_COMPILER=${CXX_COMPILER}
+		-DAUSTERLITZ_ARCH=${ARCH}
+		-DAUSTERLITZ_PGO=${stage}
+		-DAUSTERLITZ_PGO_DIR=${profile_dir})
+	run_step(${CMAKE_COMMAND} --build "${BINARY_DIR}/${stage}" --target austerlitz --parallel)
+endfunction()
+
+message(STATUS "PGO: instrumented build")
+build_stage(GENERATE)
+
+message(STATUS "PGO: training run (bench depth ${BENCH_DEPTH})")
+run_step("${BINARY_DIR}/GENERATE/austerlitz" bench ${BENCH_DEPTH})
+
+# clang writes raw profiles, which have to be merged first
+if(CXX_COMPILER_ID MATCHES "Clang")
+	file(GLOB raw_profiles "${profile_dir}/*.profraw")
+	find_program(LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+	run_step(${LLVM_PROFDATA} merge -output=${profile_dir}/austerlitz.profdata ${raw_profiles})
+endif()
+
+message(STATUS "PGO: optimized build")
+build_stage(USE)
+
+message(STATUS "PGO: done - ${BINARY_DIR}/USE/austerlitz")
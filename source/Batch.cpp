@@ -0,0 +1,645 @@
+#include "Batch.h"
+#include "BitBoardsSet.h"
+#include "Search.h"
+#include "Zobrist.h"
+#include "UCI.h"
+#include "MoveGeneration.h"
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+	static constexpr int
+		default_hash_MB = 16,
+		max_workers = 256;
+
+	// quote CSV field only if needed
+	std::string csvField(const std::string& s) {
+		if (s.find_first_of(",\"\n") == std::string::npos)
+			return s;
+
+		std::string quoted = "\"";
+		for (const char c : s)
+			quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+		return quoted + '"';
+	}
+
+	std::string jsonString(const std::string& s) {
+		std::string escaped = "\"";
+		for (const char c : s) {
+			if (c == '"' or c == '\\') escaped += '\\';
+			escaped += c;
+		}
+		return escaped + '"';
+	}
+
+	// read 'depth N', 'nodes N' or 'movetime N' argument
+	bool parseLimit(const std::string& key, std::istream& args, Batch::Limit& limit) {
+		if (key != "depth" and key != "nodes" and key != "movetime")
+			return false;
+
+		limit.type = key == "depth" ? Batch::Limit::DEPTH : key == "nodes" ? Batch::Limit::NODES : Batch::Limit::MOVETIME;
+		args >> limit.value;
+		limit.value = std::max<ULL>(limit.value, 1);
+		return true;
+	}
+
+	// move in coordinate notation, as printed in uci output
+	std::string coordinates(const MoveItem::iMove move) {
+		std::string str = std::string(index_to_square[move.getOrigin()]) + index_to_square[move.getTarget()];
+		if (move.getPromo()) str += " nbrq"[move.getPromo()];
+		return str;
+	}
+
+	// strip check, mate and annotation symbols of SAN move
+	inline std::string bareSAN(std::string san) {
+		san.erase(san.find_last_not_of("+#!?") + 1);
+		return san;
+	}
+
+	// list of moves given as SAN (or coordinate) operand contains the move
+	bool containsMove(const std::string& operand, const std::string& san, const std::string& coord) {
+		std::istringstream moves(operand);
+
+		for (std::string move; moves >> move; )
+			if (bareSAN(move) == bareSAN(san) or move == coord) return true;
+
+		return false;
+	}
+
+	inline std::string csvHeader() {
+		return "index,id,fen,bestmove,score,depth,nodes,time,pv";
+	}
+
+	// single output record without trailing newline
+	std::string record(const size_t index, const Batch::Position& pos, const Batch::Result& res, const bool jsonl) {
+		const auto id = pos.ops.find("id");
+		const std::string id_str = id != pos.ops.end() ? id->second : "";
+		std::ostringstream rec;
+
+		if (jsonl) {
+			rec << "{\"index\":" << index
+				<< ",\"id\":" << jsonString(id_str)
+				<< ",\"fen\":" << jsonString(pos.fen)
+				<< ",\"bestmove\":" << jsonString(res.best_move)
+				<< ",\"score\":" << jsonString(res.score)
+				<< ",\"depth\":" << res.depth
+				<< ",\"nodes\":" << res.nodes
+				<< ",\"time\":" << res.time
+				<< ",\"pv\":" << jsonString(res.pv) << '}';
+		}
+		else {
+			rec << index << ',' << csvField(id_str) << ',' << csvField(pos.fen) << ','
+				<< res.best_move << ',' << res.score << ',' << res.depth << ','
+				<< res.nodes << ',' << res.time << ',' << res.pv;
+		}
+
+		return rec.str();
+	}
+
+	// analyse single EPD line, empty string for lines without a position
+	std::string processLine(const size_t index, const std::string& line, const Batch::Limit& limit, const bool jsonl) {
+		Batch::Position pos;
+
+		if (!Batch::parseEPD(line, pos))
+			return "";
+
+		BBs.parseFEN(pos.fen);
+		return record(index, pos, Batch::analyse(limit), jsonl);
+	}
+
+	// lines without a position are skipped, but still counted to keep indexes equal to line numbers
+	inline bool isPositionLine(const std::string& line) {
+		const size_t first = line.find_first_not_of(" \t\r");
+		return first != std::string::npos and line[first] != '#';
+	}
+
+	void runSequential(std::istream& src, const Batch::Job& job, const Batch::Sink& sink) {
+		std::string line;
+
+		for (size_t index = 1; std::getline(src, line); index++)
+			if (isPositionLine(line) and !sink(job(index, line))) break;
+	}
+
+#if !defined(_WIN32)
+
+	inline bool writeAll(const int fd, const std::string& data) {
+		for (size_t done = 0; done < data.size(); ) {
+			const ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+			if (n <= 0) return false;
+			done += n;
+		}
+		return true;
+	}
+
+	// read next newline terminated message, false once the pipe is closed
+	bool readLine(const int fd, std::string& buffer, std::string& line) {
+		char chunk[4096];
+		size_t eol;
+
+		while ((eol = buffer.find('\n')) == std::string::npos) {
+			const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+			if (n <= 0) return false;
+			buffer.append(chunk, n);
+		}
+
+		line = buffer.substr(0, eol);
+		buffer.erase(0, eol + 1);
+		return true;
+	}
+
+	// worker receives 'index<TAB>line' jobs and answers every job with a single output line, until the job pipe is closed
+	void workerLoop(const int job_fd, const int result_fd, const Batch::Job& job) {
+		std::string buffer, msg;
+
+		while (readLine(job_fd, buffer, msg)) {
+			const size_t tab = msg.find('\t');
+			const size_t index = std::stoull(msg.substr(0, tab));
+
+			if (!writeAll(result_fd, job(index, msg.substr(tab + 1)) + '\n'))
+				break;
+		}
+	}
+
+	struct Worker {
+		Worker(const pid_t g_pid, const int g_job_fd, const int g_result_fd) noexcept
+			: pid(g_pid), job_fd(g_job_fd), result_fd(g_result_fd) {}
+
+		pid_t pid;
+		int job_fd, result_fd;
+		std::string buffer;
+		bool busy = false;
+	};
+
+	// dynamic dispatch - every idle worker gets the next line of the input and outputs are passed
+	// to the sink in order of completion. Once the sink refuses an output, no new jobs are sent
+	void runWorkers(std::istream& src, const Batch::Job& job, const Batch::Sink& sink, const int workers_num) {
+		std::vector<Worker> workers;
+
+		// don't duplicate buffered output in children and don't die on a pipe of crashed worker -
+		// previous handler is restored once the workers are done
+		OS << std::flush;
+		const auto prev_sigpipe = std::signal(SIGPIPE, SIG_IGN);
+
+		for (int i = 0; i < workers_num; i++) {
+			int job_pipe[2], result_pipe[2];
+
+			if (pipe(job_pipe) or pipe(result_pipe)) {
+				OS << "info string unable to create worker pipes\n";
+				break;
+			}
+
+			const pid_t pid = fork();
+
+			if (pid == 0) {
+				// pipe ends inherited from already spawned workers would keep their job pipes open
+				for (const auto& w : workers) {
+					close(w.job_fd);
+					close(w.result_fd);
+				}
+				close(job_pipe[1]);
+				close(result_pipe[0]);
+
+				workerLoop(job_pipe[0], result_pipe[1], job);
+				_exit(0);
+			}
+
+			close(job_pipe[0]);
+			close(result_pipe[1]);
+
+			if (pid < 0) {
+				close(job_pipe[1]);
+				close(result_pipe[0]);
+				OS << "info string unable to fork worker\n";
+				break;
+			}
+
+			workers.emplace_back(pid, job_pipe[1], result_pipe[0]);
+		}
+
+		if (workers.empty()) {
+			std::signal(SIGPIPE, prev_sigpipe);
+			runSequential(src, job, sink);
+			return;
+		}
+
+		std::string line;
+		size_t index = 0;
+		bool eof = false;
+
+		// send next position line to the worker, close its job pipe when the input is exhausted
+		const auto dispatch = [&](Worker& w) {
+			while (!eof) {
+				if (!std::getline(src, line)) {
+					eof = true;
+					break;
+				}
+				else if (index++, isPositionLine(line)) {
+					w.busy = writeAll(w.job_fd, std::to_string(index) + '\t' + line + '\n');
+					return;
+				}
+			}
+
+			close(w.job_fd);
+			w.job_fd = -1;
+		};
+
+		for (auto& w : workers)
+			dispatch(w);
+
+		std::vector<pollfd> fds;
+		std::vector<Worker*> polled;
+
+		for (;;) {
+			fds.clear();
+			polled.clear();
+
+			for (auto& w : workers) {
+				if (w.busy) {
+					fds.push_back({ w.result_fd, POLLIN, 0 });
+					polled.push_back(&w);
+				}
+			}
+
+			if (fds.empty())
+				break;
+
+			if (poll(fds.data(), fds.size(), -1) < 0)
+				continue;
+
+			for (size_t i = 0; i < fds.size(); i++) {
+				if (!fds[i].revents)
+					continue;
+
+				Worker& w = *polled[i];
+				std::string output;
+				w.busy = false;
+
+				if (!readLine(w.result_fd, w.buffer, output)) {
+					OS << "info string worker " << w.pid << " terminated unexpectedly\n";
+					continue;
+				}
+
+				eof |= !sink(output);
+				dispatch(w);
+			}
+		}
+
+		for (auto& w : workers) {
+			if (w.job_fd != -1) close(w.job_fd);
+			close(w.result_fd);
+			waitpid(w.pid, nullptr, 0);
+		}
+
+		std::signal(SIGPIPE, prev_sigpipe);
+	}
+
+#endif
+
+} // namespace
+
+
+bool Batch::parseEPD(const std::string& line, Position& pos) {
+	std::istringstream strm(line);
+	std::string field, hmvc, fmvn;
+
+	pos.fen.clear();
+	pos.ops.clear();
+
+	if (!isPositionLine(line))
+		return false;
+
+	// piece placement, side to move, castling and en passant
+	for (int i = 0; i < 4; i++) {
+		if (!(strm >> field))
+			return false;
+		pos.fen += (i ? " " : "") + field;
+	}
+
+	// FEN move counters are optional, EPD operations follow the four fields
+	const auto rest_pos = strm.tellg();
+	if (strm >> hmvc >> fmvn and std::all_of(hmvc.begin(), hmvc.end(), ::isdigit) and std::all_of(fmvn.begin(), fmvn.end(), ::isdigit))
+		pos.fen += ' ' + hmvc + ' ' + fmvn;
+	else {
+		pos.fen += " 0 1";
+		strm.clear();
+		strm.seekg(rest_pos);
+	}
+
+	// operations - 'opcode operand...;'
+	for (std::string op; std::getline(strm, op, ';'); ) {
+		std::istringstream op_strm(op);
+		std::string opcode, operand;
+
+		if (!(op_strm >> opcode))
+			continue;
+
+		std::getline(op_strm >> std::ws, operand);
+		operand.erase(operand.find_last_not_of(" \t\r") + 1);
+		operand.erase(std::remove(operand.begin(), operand.end(), '"'), operand.end());
+		pos.ops[opcode] = operand;
+	}
+
+	return true;
+}
+
+Batch::Result Batch::analyse(const Limit& limit) {
+	// every position is searched from scratch, as in bench
+	tt.clear();
+	rep_tt.clear();
+	m_search.move_order.clearCountermove();
+	m_search.move_order.clearHistory();
+	m_search.prev_move = MoveItem::iMove::no_move;
+
+	m_search.time_data.setFixedTime(limit.type == Limit::MOVETIME ? static_cast<int>(limit.value) : 0);
+	m_search.time_data.setNodeLimit(limit.type == Limit::NODES ? limit.value : 0);
+
+	return search(limit.type == Limit::DEPTH ? static_cast<int>(std::clamp<ULL>(limit.value, 1, mSearch::max_depth)) : mSearch::max_depth);
+}
+
+Batch::Result Batch::search(const int depth) {
+	std::ostream* const out = OS_PTR;
+	std::ostringstream log;
+	Timer timer;
+	Result res;
+
+	// capture uci output of the search
+	OS_PTR = &log;
+	timer.go();
+	m_search.bestMove(depth);
+	res.time = timer.duration();
+	OS_PTR = out;
+
+	res.nodes = m_search.searchedNodes();
+
+	// the last info line holds the result of the last finished iteration
+	std::istringstream lines(log.str());
+
+	for (std::string line, token; std::getline(lines, line); ) {
+		std::istringstream tokens(line);
+		tokens >> token;
+
+		if (token == "bestmove")
+			tokens >> res.best_move;
+		else if (token == "info" and tokens >> token and token == "score") {
+			std::string type, value;
+			tokens >> type >> value;
+			res.score = type + ' ' + value;
+
+			Iteration iter{};
+
+			while (tokens >> token) {
+				if (token == "depth")
+					tokens >> iter.depth;
+				else if (token == "nodes")
+					tokens >> iter.nodes;
+				else if (token == "time")
+					tokens >> iter.time;
+				else if (token == "pv") {
+					res.pv.clear();
+					while (tokens >> token)
+						res.pv += (res.pv.empty() ? "" : " ") + token;
+				}
+			}
+
+			iter.move = res.pv.substr(0, res.pv.find(' '));
+			res.depth = iter.depth;
+			res.iterations.push_back(iter);
+		}
+	}
+
+	return res;
+}
+
+void Batch::run(std::istream& args) {
+	std::string path, key;
+	Limit limit;
+	int workers_num = 1, hash_MB = default_hash_MB;
+	bool jsonl = false;
+
+	if (!(args >> path)) {
+		OS << "batch <file> [depth N | nodes N | movetime N] [workers N] [hash MB] [format csv | jsonl]\n";
+		return;
+	}
+
+	while (args >> key) {
+		if (parseLimit(key, args, limit))
+			continue;
+		else if (key == "workers") args >> workers_num;
+		else if (key == "hash")    args >> hash_MB;
+		else if (key == "format") {
+			args >> key;
+			jsonl = key == "jsonl";
+		}
+	}
+
+	std::ifstream src(path);
+
+	if (!src.is_open()) {
+		OS << "info string batch file '" << path << "' not found\n";
+		return;
+	}
+
+	const size_t prev_hash_MB = tt.sizeMB();
+	tt.setSize(hash_MB);
+
+	if (!jsonl)
+		OS << csvHeader() << std::endl;
+
+	const auto job = [&](const size_t index, const std::string& line) { return processLine(index, line, limit, jsonl); };
+
+	dispatch(src, job, [](const std::string& rec) {
+		if (!rec.empty()) OS << rec << std::endl;
+		return true;
+	}, workers_num);
+
+	// restore engine state
+	tt.setSize(prev_hash_MB);
+	rep_tt.clear();
+	BBs.parseFEN(BitBoardsSet::start_pos);
+}
+
+std::string Batch::toSAN(const MoveItem::iMove move) {
+	const int origin = move.getOrigin(), target = move.getTarget(), pc = move.getPiece();
+	std::string san;
+
+	if (move.isCastling())
+		san = (target & 7) == 6 ? "O-O" : "O-O-O";
+	else {
+		if (move.getPiece() == PAWN) {
+			if (move.isCapture()) san += index_to_square[origin][0];
+		}
+		else {
+			san += "PNBRQK"[pc];
+
+			// disambiguate with origin file, rank or both, if other piece of the same type reaches the target
+			MoveList ml;
+			MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+			bool ambiguous = false, same_file = false, same_rank = false;
+
+			for (const auto& other : ml) {
+				if (other == move or static_cast<int>(other.getPiece()) != pc or other.getTarget() != target)
+					continue;
+
+				ambiguous = true;
+				same_file |= (other.getOrigin() & 7) == (origin & 7);
+				same_rank |= (other.getOrigin() >> 3) == (origin >> 3);
+			}
+
+			if (ambiguous) {
+				if (!same_file) san += index_to_square[origin][0];
+				else if (!same_rank) san += index_to_square[origin][1];
+				else san += index_to_square[origin];
+			}
+		}
+
+		if (move.isCapture()) san += 'x';
+		san += index_to_square[target];
+
+		if (move.getPromo())
+			san += std::string("=") + " NBRQ"[move.getPromo()];
+	}
+
+	// check or checkmate
+	const BitBoardsSet bbs_cpy = BBs;
+	const gState gstate_cpy = game_state;
+	const U64 hash_cpy = hash.key;
+
+	MovePerform::makeMove(move);
+
+	if (isSquareAttacked(getLS1BIndex(BBs[nWhiteKing + game_state.turn]), game_state.turn)) {
+		MoveList replies;
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(replies);
+		san += replies.size() ? '+' : '#';
+	}
+
+	MovePerform::unmakeMove(bbs_cpy, gstate_cpy);
+	hash.key = hash_cpy;
+
+	return san;
+}
+
+void Batch::epdTest(std::istream& args) {
+	std::string path, key;
+	Limit limit{ Limit::MOVETIME, 1000 };
+
+	if (!(args >> path)) {
+		OS << "epdtest <file> [movetime N | nodes N | depth N]\n";
+		return;
+	}
+
+	while (args >> key)
+		parseLimit(key, args, limit);
+
+	std::ifstream src(path);
+
+	if (!src.is_open()) {
+		OS << "info string epd file '" << path << "' not found\n";
+		return;
+	}
+
+	std::vector<Position> suite;
+	Position pos;
+
+	for (std::string line; std::getline(src, line); ) {
+		if (parseEPD(line, pos) and (pos.ops.count("bm") or pos.ops.count("am")))
+			suite.push_back(pos);
+	}
+
+	size_t solved = 0;
+	ULL total_nodes = 0, solve_nodes = 0;
+	long long total_time = 0, solve_time = 0;
+
+	for (size_t i = 0; i < suite.size(); i++) {
+		const Position& p = suite[i];
+		const auto id = p.ops.find("id");
+		const std::string bm = p.ops.count("bm") ? p.ops.at("bm") : "", am = p.ops.count("am") ? p.ops.at("am") : "";
+
+		BBs.parseFEN(p.fen);
+
+		// SAN of root moves, has to be computed before the search changes the board
+		MoveList ml;
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+		std::map<std::string, std::string> san_of;
+
+		for (const auto& move : ml)
+			san_of[coordinates(move)] = toSAN(move);
+
+		const auto correct = [&](const std::string& coord) {
+			const auto san = san_of.find(coord);
+			if (san == san_of.end()) return false;
+
+			return (bm.empty() or containsMove(bm, san->second, coord))
+				and (am.empty() or !containsMove(am, san->second, coord));
+		};
+
+		const Result res = analyse(limit);
+		total_nodes += res.nodes;
+		total_time += res.time;
+
+		// solution is the first iteration, after which the best move stays correct
+		const bool is_solved = correct(res.best_move);
+		size_t first = res.iterations.size();
+
+		while (is_solved and first > 0 and correct(res.iterations[first - 1].move))
+			first--;
+
+		const ULL nodes = first < res.iterations.size() ? res.iterations[first].nodes : res.nodes;
+		const long long time = first < res.iterations.size() ? res.iterations[first].time : res.time;
+
+		if (is_solved) {
+			solved++;
+			solve_nodes += nodes;
+			solve_time += time;
+		}
+
+		const auto found = san_of.find(res.best_move);
+
+		OS << std::setw(4) << i + 1 << '/' << suite.size() << ' '
+			<< std::left << std::setw(12) << (id != p.ops.end() ? id->second : "-")
+			<< (is_solved ? "solved " : "failed ")
+			<< std::setw(16) << (bm.empty() ? "am " + am : "bm " + bm)
+			<< "move " << std::setw(8) << (found != san_of.end() ? found->second : res.best_move) << std::right;
+
+		if (is_solved)
+			OS << " time " << std::setw(6) << time << " ms nodes " << std::setw(10) << nodes;
+
+		OS << std::endl;
+	}
+
+	OS << "===========================\n"
+		<< "Solved          : " << solved << '/' << suite.size() << '\n'
+		<< "Total time (ms) : " << total_time << '\n'
+		<< "Nodes searched  : " << total_nodes << '\n'
+		<< "Solve time (ms) : " << solve_time << '\n'
+		<< "Nodes to solve  : " << solve_nodes << '\n';
+
+	// restore engine state
+	rep_tt.clear();
+	BBs.parseFEN(BitBoardsSet::start_pos);
+}
+
+void Batch::dispatch(std::istream& src, const Job& job, const Sink& sink, const int workers_num) {
+#if defined(_WIN32)
+	if (workers_num > 1)
+		OS << "info string worker processes not supported on this platform, using single worker\n";
+	runSequential(src, job, sink);
+#else
+	if (workers_num > 1)
+		runWorkers(src, job, sink, std::min(workers_num, max_workers));
+	else runSequential(src, job, sink);
+#endif
+}
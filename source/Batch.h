@@ -0,0 +1,75 @@
+#pragma once
+
+#include "MoveItem.h"
+#include <functional>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+// batch analysis of FEN/EPD files - every position is searched with the same limit and results are
+// streamed as CSV or JSONL records. Search state of the engine is global, so positions are dispatched
+// between forked worker processes, each owning its own search context and transposition table
+namespace Batch {
+
+	// search limit applied to every position
+	struct Limit {
+		enum Type { DEPTH, NODES, MOVETIME } type = DEPTH;
+		ULL value = 8;
+	};
+
+	// single FEN or EPD record - position and EPD operations (opcode -> operand, quotes stripped)
+	struct Position {
+		std::string fen;
+		std::map<std::string, std::string> ops;
+	};
+
+	// first pv move and counters of a finished iteration
+	struct Iteration {
+		std::string move;
+		int depth;
+		ULL nodes;
+		long long time;
+	};
+
+	// result of a single search
+	struct Result {
+		std::string best_move, score, pv;
+		int depth = 0;
+		ULL nodes = 0;
+		long long time = 0;
+		std::vector<Iteration> iterations;
+	};
+
+	// parse FEN or EPD line - false for empty, comment or malformed lines
+	bool parseEPD(const std::string& line, Position& pos);
+
+	// search current position from scratch with given limit, search output is silenced
+	Result analyse(const Limit& limit);
+
+	// search current position up to given depth - time and node limits have to be already set,
+	// transposition table and histories are kept
+	Result search(int depth);
+
+	// standard algebraic notation of a legal move in the current position
+	std::string toSAN(MoveItem::iMove move);
+
+	// EPD test suite: '<file> [movetime N | nodes N | depth N]' - positions are solved when the best move
+	// is one of 'bm' moves and none of 'am' moves, 1 second per position by default
+	void epdTest(std::istream& args);
+
+	// job of a worker - gets index (line number) and line of the input, returns single output line
+	using Job = std::function<std::string(size_t index, const std::string& line)>;
+
+	// receives job outputs in order of completion, returns false to stop sending new jobs
+	using Sink = std::function<bool(const std::string& output)>;
+
+	// run job for every non-empty, non-comment line of the input in forked worker processes
+	// (sequentially with a single worker or on Windows)
+	void dispatch(std::istream& src, const Job& job, const Sink& sink, int workers_num);
+
+	// command line batch: '<file> [depth N | nodes N | movetime N] [workers N] [hash MB] [format csv | jsonl]'
+	void run(std::istream& args);
+
+} // namespace Batch
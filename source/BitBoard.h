@@ -5,8 +5,13 @@
 #include <iostream>
 #include <array>
 #include <cassert>
+#if defined(_MSC_VER) or defined(__INTEL_COMPILER)
 #include <nmmintrin.h>
 #include <intrin.h>
+#endif
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
 #include "staticLookup.h"
 #include "UCI.h"
 
@@ -186,7 +191,7 @@ namespace {
 #if defined(__INTEL_COMPILER) or defined(_MSC_VER)
 		return static_cast<int>(_mm_popcnt_u64(x));
 #elif defined(__GNUC__)
-		return __builtin_popcount(x);
+		return __builtin_popcountll(x);
 #else
 		int c;
 		for (c = 0; x; x &= x - 1, c++);
@@ -219,7 +224,7 @@ inline int getLS1BIndex(U64 bb) {
 
 inline int getMS1BIndex(U64 bb) {
 	assert(bb != eU64);
-	return __builtin_clzll(bb);
+	return 63 ^ __builtin_clzll(bb);
 }
 #else
 inline constexpr int getLS1BIndex(U64 bb) noexcept {
@@ -302,7 +307,7 @@ inline constexpr U64 islandsEastFile(U64 fileset) noexcept {
 
 
 namespace islandCountLookUp {
-	auto lookup = cexpr::CexprArr<false, int, 256>([](U64 bb) {
+	constexpr auto lookup = cexpr::CexprArr<false, int, 256>([](U64 bb) {
 		int isl_count = 0, i = 0;
 
 		while (i < 8) {
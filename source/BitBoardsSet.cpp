@@ -88,9 +88,10 @@ void BitBoardsSet::parseGState(const std::string& fen, int i) {
 		}
 	}
 
+	// FEN stores square passed by double-pushed pawn, ep_sq is the square of pawn itself
 	game_state.ep_sq = -1;
 	if (fen[++i] != '-') {
-		game_state.ep_sq = (fen[i] - 'a') + (fen[i + 1] - '1') * 8;
+		game_state.ep_sq = (fen[i] - 'a') + (fen[i + 1] - '1') * 8 + (game_state.turn == WHITE ? -8 : 8);
 	} 
 
 	i += 2;
@@ -128,7 +129,7 @@ void BitBoardsSet::printBoard() {
 	}
 
 	states += ' ';
-	states += game_state.ep_sq == -1 ? "-" : index_to_square[game_state.ep_sq];
+	states += game_state.ep_sq == -1 ? "-" : index_to_square[game_state.ep_sq + (game_state.turn == WHITE ? 8 : -8)];
 	states += ' ';
 	states += std::to_string(game_state.halfmove);
 	states += ' ';
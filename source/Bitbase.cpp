@@ -0,0 +1,127 @@
+#include "Bitbase.h"
+#include "AttackTables.h"
+#include "MagicBitBoards.h"
+#include <bitset>
+#include <cassert>
+
+
+namespace {
+
+	// pawn on one of 24 squares a2-d7, kings on any squares
+	static constexpr int pawn_squares = 24, positions = pawn_squares * 64 * 64;
+
+	// won positions for white to move and for black to move
+	std::bitset<positions> white_wins, black_loses;
+
+	// pawn square a2-d7 numbered 0-23 rank by rank, then white king square and black king square
+	inline constexpr int index(const int psq, const int wksq, const int bksq) noexcept {
+		return (((((psq >> 3) - 1) << 2) | (psq & 7)) << 12) | (wksq << 6) | bksq;
+	}
+
+	// position decoded from index - neither king stands on the pawn square or touches the other king
+	struct KPK {
+		int psq, wksq, bksq;
+
+		explicit KPK(const int idx) noexcept :
+			psq(8 + ((idx >> 14) << 3) + ((idx >> 12) & 3)), wksq((idx >> 6) & 63), bksq(idx & 63) {}
+
+		bool valid() const noexcept {
+			return wksq != psq and bksq != psq and wksq != bksq and !(cking_attacks[wksq] & bitU64(bksq));
+		}
+
+		// squares black king may go to, capture of undefended pawn included
+		U64 blackMoves() const noexcept {
+			return cking_attacks[bksq] & ~cking_attacks[wksq] & ~cpawn_attacks[WHITE][psq];
+		}
+
+		bool pawnChecks() const noexcept {
+			return cpawn_attacks[WHITE][psq] & bitU64(bksq);
+		}
+
+		// promotion wins, if the new queen or rook survives and doesn't stalemate black king,
+		// KQK and KRK are won then - knight and bishop promotions only draw
+		bool promotionWins() const noexcept {
+			const int qsq = psq + 8;
+			if ((cking_attacks[bksq] & bitU64(qsq)) and !(cking_attacks[wksq] & bitU64(qsq)))
+				return false;
+
+			// black king doesn't block the lines of the new piece
+			const U64 occ = bitU64(wksq) | bitU64(qsq);
+			for (const U64 piece_att : { attack<QUEEN>(occ, qsq), attack<ROOK>(occ, qsq) }) {
+				if ((cking_attacks[bksq] & ~cking_attacks[wksq] & ~piece_att) or (piece_att & bitU64(bksq)))
+					return true;
+			}
+
+			return false;
+		}
+
+		// white to move wins, if any king move or pawn push reaches won position
+		bool whiteWins() const {
+			U64 moves = cking_attacks[wksq] & ~cking_attacks[bksq] & ~bitU64(psq);
+			while (moves) {
+				if (black_loses[index(psq, popLS1B(moves), bksq)])
+					return true;
+			}
+
+			const int push = psq + 8;
+			if (push == wksq or push == bksq)
+				return false;
+			if ((push >> 3) == 7)
+				return promotionWins();
+			if (black_loses[index(push, wksq, bksq)])
+				return true;
+
+			// double push from the second rank
+			return (psq >> 3) == 1 and push + 8 != wksq and push + 8 != bksq and black_loses[index(push + 8, wksq, bksq)];
+		}
+
+		// black to move loses, if it's checkmated or every king move reaches won position - pawn capture draws
+		bool blackLoses() const {
+			U64 moves = blackMoves();
+			if (!moves)
+				return pawnChecks();
+
+			if (moves & bitU64(psq))
+				return false;
+
+			while (moves) {
+				if (!white_wins[index(psq, wksq, popLS1B(moves))])
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+} // namespace
+
+
+bool Bitbases::probeKPK(const int wksq, const int wpsq, const int bksq, const bool stm) {
+	assert((wpsq & 7) <= 3 and (wpsq >> 3) >= 1 and (wpsq >> 3) <= 6);
+	return stm == WHITE ? white_wins[index(wpsq, wksq, bksq)] : black_loses[index(wpsq, wksq, bksq)];
+}
+
+void InitState::initBitbases() {
+	// white to move can't stand in front of black king attacked by pawn
+	std::bitset<positions> white_valid, black_valid;
+	for (int idx = 0; idx < positions; idx++) {
+		const KPK pos(idx);
+		black_valid[idx] = pos.valid();
+		white_valid[idx] = pos.valid() and !pos.pawnChecks();
+	}
+
+	// retrograde iteration - every pass resolves wins one move longer, the rest are draws
+	for (bool changed = true; changed; ) {
+		changed = false;
+
+		for (int idx = 0; idx < positions; idx++) {
+			if (white_valid[idx] and !white_wins[idx] and KPK(idx).whiteWins())
+				white_wins[idx] = changed = true;
+		}
+
+		for (int idx = 0; idx < positions; idx++) {
+			if (black_valid[idx] and !black_loses[idx] and KPK(idx).blackLoses())
+				black_loses[idx] = changed = true;
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "BitBoard.h"
+
+
+// endgame bitbases, generated at startup by retrograde analysis
+namespace Bitbases {
+
+	// king and pawn vs king - true if position is a win for the pawn side. Position has to be normalized:
+	// pawn side is white and pawn stands on a-d files, stm is the side to move
+	bool probeKPK(int wksq, int wpsq, int bksq, bool stm);
+
+}
+
+
+namespace InitState {
+	// generate KPK bitbase
+	void initBitbases();
+}
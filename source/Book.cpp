@@ -0,0 +1,189 @@
+#include "Book.h"
+#include "MoveGeneration.h"
+#include "Zobrist.h"
+#include "UCI.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+	// single book record - key, move, weight and learn data, all stored big-endian
+	static constexpr size_t entry_size = 16;
+
+	const uint8_t* book_data = nullptr;
+	size_t book_entries = 0;
+	void* base_address = nullptr;
+	uint64_t mapping = 0;
+
+	template <typename T>
+	inline T readBigEndian(const uint8_t* ptr) noexcept {
+		T v = 0;
+		for (size_t i = 0; i < sizeof(T); i++)
+			v = static_cast<T>((v << 8) | ptr[i]);
+		return v;
+	}
+
+	inline U64 entryKey(const size_t i) noexcept {
+		return readBigEndian<U64>(book_data + i * entry_size);
+	}
+
+	inline uint16_t entryMove(const size_t i) noexcept {
+		return readBigEndian<uint16_t>(book_data + i * entry_size + 8);
+	}
+
+	inline uint16_t entryWeight(const size_t i) noexcept {
+		return readBigEndian<uint16_t>(book_data + i * entry_size + 10);
+	}
+
+	void close() {
+		if (base_address) {
+#if defined(_WIN32)
+			UnmapViewOfFile(base_address);
+			CloseHandle(reinterpret_cast<HANDLE>(mapping));
+#else
+			munmap(base_address, mapping);
+#endif
+		}
+
+		base_address = nullptr;
+		book_data = nullptr;
+		book_entries = 0;
+	}
+
+	// find legal move matching the polyglot encoded one - castling is encoded as king capturing it's rook
+	MoveItem::iMove decodeMove(const uint16_t pmove) {
+		const int target = pmove & 63, origin = (pmove >> 6) & 63, promo = (pmove >> 12) & 7;
+		MoveList ml;
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+
+		for (const auto& move : ml) {
+			const int move_target = move.isCastling()
+				? (move.getTarget() > move.getOrigin() ? move.getOrigin() + 3 : move.getOrigin() - 4)
+				: move.getTarget();
+
+			if (move.getOrigin() == origin and move_target == target and static_cast<int>(move.getPromo()) == promo)
+				return move;
+		}
+
+		return MoveItem::iMove::no_move;
+	}
+
+} // namespace
+
+
+void Book::open(const std::string& path) {
+	close();
+
+	if (path.empty() or path == "<empty>")
+		return;
+
+#if defined(_WIN32)
+	HANDLE fd = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (fd == INVALID_HANDLE_VALUE) {
+		OS << "info string book file " << path << " not found\n";
+		return;
+	}
+
+	DWORD size_high;
+	const DWORD size_low = GetFileSize(fd, &size_high);
+	const size_t size = (static_cast<uint64_t>(size_high) << 32) | size_low;
+
+	HANDLE mmap = size ? CreateFileMapping(fd, nullptr, PAGE_READONLY, size_high, size_low, nullptr) : nullptr;
+	CloseHandle(fd);
+	if (!mmap)
+		return;
+
+	mapping = reinterpret_cast<uint64_t>(mmap);
+	base_address = MapViewOfFile(mmap, FILE_MAP_READ, 0, 0, 0);
+	if (!base_address) {
+		CloseHandle(mmap);
+		return;
+	}
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		OS << "info string book file " << path << " not found\n";
+		return;
+	}
+
+	struct stat statbuf;
+	fstat(fd, &statbuf);
+	const size_t size = statbuf.st_size;
+
+	base_address = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	::close(fd);
+
+	if (base_address == MAP_FAILED) {
+		base_address = nullptr;
+		return;
+	}
+
+	mapping = size;
+#endif
+
+	book_data = static_cast<const uint8_t*>(base_address);
+	book_entries = size / entry_size;
+
+	OS << "info string book " << path << " with " << book_entries << " entries\n";
+}
+
+MoveItem::iMove Book::probe() {
+	if (!book_entries)
+		return MoveItem::iMove::no_move;
+
+	const U64 key = Zobrist::polyglotKey();
+
+	// binary search for the first entry of the position
+	size_t low = 0, high = book_entries;
+	while (low < high) {
+		const size_t mid = (low + high) / 2;
+		if (entryKey(mid) < key) low = mid + 1;
+		else high = mid;
+	}
+
+	// collect legal moves of the position with their weights
+	std::vector<std::pair<MoveItem::iMove, uint32_t>> moves;
+	uint32_t total_weight = 0;
+
+	for (size_t i = low; i < book_entries and entryKey(i) == key; i++) {
+		const MoveItem::iMove move = decodeMove(entryMove(i));
+
+		if (move != MoveItem::iMove::no_move) {
+			moves.emplace_back(move, entryWeight(i));
+			total_weight += entryWeight(i);
+		}
+	}
+
+	if (moves.empty())
+		return MoveItem::iMove::no_move;
+
+	// entries of the same key are sorted by weight in descending order by book generators, but don't rely on it
+	if (best_move or !total_weight) {
+		return std::max_element(moves.begin(), moves.end(),
+			[](const auto& a, const auto& b) { return a.second < b.second; })->first;
+	}
+
+	static std::mt19937 rng(static_cast<unsigned>(std::chrono::steady_clock::now().time_since_epoch().count()));
+	uint32_t pick = std::uniform_int_distribution<uint32_t>(0, total_weight - 1)(rng);
+
+	for (const auto& [move, weight] : moves) {
+		if (pick < weight) return move;
+		pick -= weight;
+	}
+
+	return moves.front().first;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "MoveItem.h"
+#include <string>
+
+
+// Polyglot opening book (.bin) - file is memory-mapped and entries of the current position
+// are found with binary search, as records are sorted by their Polyglot position key
+namespace Book {
+
+	// answer 'go' with book moves - OwnBook option
+	inline bool enabled = false;
+
+	// always play the most weighted book move instead of a weighted random one
+	inline bool best_move = false;
+
+	// map book file, empty path or '<empty>' closes the current book
+	void open(const std::string& path);
+
+	// legal book move of the current position, no_move if position is out of book
+	MoveItem::iMove probe();
+
+} // namespace Book
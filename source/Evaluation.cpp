@@ -4,6 +4,9 @@
 #include "MoveOrder.h"
 #include "Zobrist.h"
 #include "Timer.h"
+#include "Bitbase.h"
+#include <iomanip>
+#include <vector>
 
 
 namespace Eval {
@@ -54,11 +57,99 @@ namespace Eval {
 			tarrasch_passed_msk = { eU64, eU64 };
 		}
 
+		// attacks of given piece type - attack sets, mobility and king zone attackers
+		template <enumSide SIDE, enumPiece PC>
+		void pieceAttacks() {
+			U64 msk = BBs[nWhitePawn + 2 * PC + SIDE];
+			PieceList& list = pieces[SIDE][PC];
+
+			list.count = 0;
+			pt_att[SIDE][PC] = eU64;
+
+			while (msk) {
+				const int sq = popLS1B(msk);
+				U64 att;
+				int mobility;
+
+				// safe mobility of knights - do not consider squares controled by enemy pawns
+				if constexpr (PC == KNIGHT) {
+					att = attack<KNIGHT>(UINT64_MAX, sq);
+					mobility = bitCount(att & ~pt_att[!SIDE][PAWN] & BBs[nEmpty]);
+				}
+				else {
+					att = attack<PC>(BBs[nOccupied], sq);
+					mobility = bitCount(att);
+				}
+
+				list.pcs[list.count++] = { sq, mobility, att };
+				pt_att[SIDE][PC] |= att;
+
+				if (att & k_zone[!SIDE]) {
+					att_count[SIDE]++;
+					att_value[SIDE] += Value::attacker_weight[PC] * bitCount(att & k_zone[!SIDE]);
+				}
+				else if (att & k_nearby[!SIDE])
+					att_value[SIDE] += Value::attacker_weight[PC] / 5;
+			}
+		}
+
+		// squares attacked by a piece and by any lesser piece, counted by type of the attacked piece
+		template <enumSide SIDE>
+		void connectivityCount() {
+			U64 conn = pt_att[SIDE][PAWN];
+			conn_count[SIDE] = { 0, 0, 0, 0 };
+
+			for (int pc = KNIGHT; pc <= QUEEN; pc++) {
+				const U64 double_att = conn & pt_att[SIDE][pc];
+
+				conn_count[SIDE][0] += bitCount(double_att & BBs[nBlackPawn - SIDE]);
+				conn_count[SIDE][1] += bitCount(double_att & (BBs[nBlackKnight - SIDE] | BBs[nBlackBishop - SIDE]));
+				conn_count[SIDE][2] += bitCount(double_att & BBs[nBlackRook - SIDE]);
+				conn_count[SIDE][3] += bitCount(double_att & BBs[nBlackQueen - SIDE]);
+
+				conn |= pt_att[SIDE][pc];
+			}
+		}
+
+		// single attack map pass of the position, shared by middlegame and endgame evaluation
+		template <enumSide SIDE>
+		void attackMaps() {
+			pieceAttacks<SIDE, KNIGHT>();
+			pieceAttacks<SIDE, BISHOP>();
+			pieceAttacks<SIDE, ROOK>();
+			pieceAttacks<SIDE, QUEEN>();
+		}
+
+		void attackMapsReset() {
+			pt_att[WHITE][PAWN] = PawnAttacks::anyAttackPawn<WHITE>(BBs[nWhitePawn], UINT64_MAX);
+			pt_att[BLACK][PAWN] = PawnAttacks::anyAttackPawn<BLACK>(BBs[nBlackPawn], UINT64_MAX);
+
+			attackMaps<WHITE>();
+			attackMaps<BLACK>();
+
+			connectivityCount<WHITE>();
+			connectivityCount<BLACK>();
+		}
+
 		/* common evaluation data for every game phase evaluation */
 
 		template <typename T>
 		using bothSideLookUp = std::array<T, 2>;
 
+		// attacks of single piece
+		struct PieceAttack {
+			int sq, mobility;
+			U64 att;
+		};
+
+		struct PieceList {
+			std::array<PieceAttack, 10> pcs;
+			int count;
+
+			inline const PieceAttack* begin() const noexcept { return pcs.data(); }
+			inline const PieceAttack* end() const noexcept { return pcs.data() + count; }
+		};
+
 		int passed_count, backward_count, pawn_count;
 		bothSideLookUp<int>
 			t_passed_dist, t_backw_dist, t_o_dist, s_pawn_count,
@@ -66,9 +157,115 @@ namespace Eval {
 
 		bothSideLookUp<U64> k_zone, k_nearby, tarrasch_passed_msk, open_files;
 		bothSideLookUp<std::array<U64, 5>> pt_att;
+		bothSideLookUp<std::array<PieceList, 5>> pieces;
+		bothSideLookUp<std::array<int, 4>> conn_count;
 
 	} eval_vector;
 
+	// middlegame and endgame score packed into a single integer, endgame in the upper half - every term
+	// is computed once, both phases are accumulated with one addition and tapered at the end of evaluation
+	struct Score {
+		int32_t value = 0;
+
+		constexpr Score() = default;
+		constexpr Score(const int mg, const int eg) noexcept
+			: value(static_cast<int32_t>(static_cast<uint32_t>(eg) << 16) + mg) {}
+
+		constexpr int mg() const noexcept {
+			return static_cast<int16_t>(static_cast<uint16_t>(value));
+		}
+
+		constexpr int eg() const noexcept {
+			return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(value + 0x8000) >> 16));
+		}
+
+		constexpr Score operator+(const Score s) const noexcept { return raw(value + s.value); }
+		constexpr Score operator-(const Score s) const noexcept { return raw(value - s.value); }
+		constexpr Score& operator+=(const Score s) noexcept { value += s.value; return *this; }
+		constexpr Score& operator-=(const Score s) noexcept { value -= s.value; return *this; }
+
+	private:
+		static constexpr Score raw(const int32_t v) noexcept {
+			Score s;
+			s.value = v;
+			return s;
+		}
+	};
+
+	// piece-square tables of both game phases packed into scores
+	static constexpr auto packed_pst = []() constexpr {
+		std::array<std::array<Score, 64>, 6> pst{};
+
+		for (int pc = PAWN; pc <= KING; pc++)
+			for (int sq = 0; sq < 64; sq++)
+				pst[pc][sq] = Score(Value::position_score[gState::MIDDLEGAME][pc][sq], Value::position_score[gState::ENDGAME][pc][sq]);
+
+		return pst;
+	}();
+
+	// evaluation terms as reported by evaltrace
+	namespace Terms {
+		enum Index : int {
+			MATERIAL,
+			PST,
+			PAWNS,
+			PIECES,
+			MOBILITY,
+			KING_SAFETY,
+			CONNECTIVITY,
+			TROPISM,
+			COUNT
+		};
+
+		static constexpr const char* names[COUNT] = {
+			"material", "pst", "pawns", "pieces", "mobility", "king safety", "connectivity", "tropism"
+		};
+
+		// term values - [term][side][middlegame, endgame]
+		using Table = std::array<std::array<std::array<int, 2>, 2>, COUNT>;
+	}
+
+	// evaluation trace policies - production evaluation is instantiated with NoTrace, which compiles to nothing
+	struct NoTrace {
+		static inline void add(int, bool, double = 1.) noexcept {}
+		static inline void add(int, bool, double, double) noexcept {}
+		static inline void term(int, bool, Score) noexcept {}
+		static inline void scale(double, double) noexcept {}
+	};
+
+	// term trace used by evaltrace - score of every term, side and phase
+	struct TermTrace : NoTrace {
+		static inline Terms::Table* table = nullptr;
+
+		static inline void term(const int t, const bool side, const Score s) noexcept {
+			(*table)[t][side][0] += s.mg();
+			(*table)[t][side][1] += s.eg();
+		}
+	};
+
+	// linear trace used by the tuner - collects white relative coefficients of the parameters
+	struct LinearTrace {
+		static inline Params::Coefficients* coef = nullptr;
+		// weights of middlegame and endgame score in the tapered score
+		static inline double mg_weight = 1., eg_weight = 0.;
+
+		// parameter used by both game phases
+		static inline void add(const int param, const bool side, const double n = 1.) noexcept {
+			add(param, side, n, n);
+		}
+
+		static inline void add(const int param, const bool side, const double mg, const double eg) noexcept {
+			const double n = mg * mg_weight + eg * eg_weight;
+			(*coef)[param] += side == WHITE ? n : -n;
+		}
+
+		static inline void term(int, bool, Score) noexcept {}
+
+		static inline void scale(const double mg, const double eg) noexcept {
+			mg_weight = mg, eg_weight = eg;
+		}
+	};
+
 	// bonus for distance from promotion square
 	template <enumSide SIDE>
 	inline int promotionDistanceBonus(U64 bb) {
@@ -77,25 +274,24 @@ namespace Eval {
 	}
 
 	// connectivity bonus - squares controlled by at least two pieces
-	template <enumSide SIDE, gState::gPhase Phase>
-	int connectivity() {
-		U64 conn = eval_vector.pt_att[SIDE][PAWN];
-		int eval = 0;
-
-		static constexpr int pawn_phase_scale = []() constexpr {
-			if constexpr (Phase == gState::ENDGAME)
-				return Value::ENDGAME_PAWN_ATTACK;
-			return Value::PAWN_ATTACK;
-		}();
-		
-		for (int pc = KNIGHT; pc <= QUEEN; pc++) {
-			eval += pawn_phase_scale * bitCount(conn & eval_vector.pt_att[SIDE][pc] & BBs[nBlackPawn - SIDE])
-				+ Value::MINOR_ATTACK * bitCount(conn & eval_vector.pt_att[SIDE][pc] & (BBs[nBlackKnight - SIDE] | BBs[nBlackBishop - SIDE]))
-				+ Value::ROOK_ATTACK * bitCount(conn & eval_vector.pt_att[SIDE][pc] & BBs[nBlackRook - SIDE])
-				+ Value::QUEEN_ATTACK * bitCount(conn & eval_vector.pt_att[SIDE][pc] & BBs[nBlackQueen - SIDE]);
-
-			conn |= eval_vector.pt_att[SIDE][pc];
-		}
+	template <enumSide SIDE, typename Trace>
+	Score connectivity() {
+		const auto& count = eval_vector.conn_count[SIDE];
+		const int pieces_eval = Value::MINOR_ATTACK * count[1]
+			+ Value::ROOK_ATTACK * count[2]
+			+ Value::QUEEN_ATTACK * count[3];
+
+		const Score eval(
+			Value::PAWN_ATTACK * count[0] + pieces_eval,
+			Value::ENDGAME_PAWN_ATTACK * count[0] + pieces_eval
+		);
+
+		Trace::add(Params::PAWN_ATTACK, SIDE, count[0], 0.);
+		Trace::add(Params::ENDGAME_PAWN_ATTACK, SIDE, 0., count[0]);
+		Trace::add(Params::MINOR_ATTACK, SIDE, count[1]);
+		Trace::add(Params::ROOK_ATTACK, SIDE, count[2]);
+		Trace::add(Params::QUEEN_ATTACK, SIDE, count[3]);
+		Trace::term(Terms::CONNECTIVITY, SIDE, eval);
 
 		return eval;
 	}
@@ -103,18 +299,18 @@ namespace Eval {
 	// penalty for no pawns, especially in endgame
 	template <enumSide SIDE>
 	inline int noPawnsPenalty() noexcept {
-		return (eval_vector.s_pawn_count[SIDE] == 0) * (-30);
+		return (eval_vector.s_pawn_count[SIDE] == 0) * Value::NO_PAWNS;
 	}
 
-	// king pawn tropism, considering pawns distance to own king
-	template <enumSide SIDE>
+	// king pawn tropism, considering pawns distance to own king - endgame only
+	template <enumSide SIDE, typename Trace>
 	inline int kingPawnTropism() {
 		static constexpr int scale = 16;
 		const int other_count = eval_vector.pawn_count
 			- eval_vector.passed_count
 			- eval_vector.backward_count;
 
-		return scale * (
+		const int eval = scale * (
 				eval_vector.t_passed_dist[SIDE] * Value::PASSER_WEIGHT
 				+ eval_vector.t_backw_dist[SIDE] * Value::BACKWARD_WEIGHT
 				+ eval_vector.t_o_dist[SIDE] * Value::OTHER_WEIGHT
@@ -123,6 +319,9 @@ namespace Eval {
 				+ eval_vector.backward_count * Value::BACKWARD_WEIGHT
 				+ other_count * Value::OTHER_WEIGHT + 1
 			);
+
+		Trace::term(Terms::TROPISM, SIDE, Score(0, eval));
+		return eval;
 	}
 
 	// simplified castle checking
@@ -146,47 +345,61 @@ namespace Eval {
 		return sq / 8;
 	}
 
-	// evaluation of pawn structure of given side
-	template <enumSide SIDE, gState::gPhase Phase>
-	int pawnStructureEval() {
+	// piece-square score of both game phases
+	template <enumSide SIDE, typename Trace>
+	inline Score pstScore(const int pc, const int sq) {
+		const int f_sq = flipSquare<SIDE>(sq);
+
+		Trace::add(Params::PST_MG + 64 * pc + f_sq, SIDE, 1., 0.);
+		Trace::add(Params::PST_EG + 64 * pc + f_sq, SIDE, 0., 1.);
+		return packed_pst[pc][f_sq];
+	}
+
+	// evaluation of pawn structure of given side - endgame only data is not gathered in opening
+	template <enumSide SIDE, gState::gPhase Phase, typename Trace>
+	Score pawnStructureEval() {
 		static constexpr auto vertical_pawn_shift = std::make_tuple(nortOne, soutOne);
 		U64 pawns = BBs[nWhitePawn + SIDE], passed = eU64;
-		int sq, eval = 0;
-
-		const U64 p_att = PawnAttacks::anyAttackPawn<SIDE>(BBs[nWhitePawn + SIDE], UINT64_MAX);
-		eval_vector.pt_att[SIDE][PAWN] = p_att;
+		int sq, eval = 0, shield_eval = 0, eg_eval = 0;
+		Score pst_eval;
 
+		const U64 p_att = eval_vector.pt_att[SIDE][PAWN];
 		const bool is_pawn_endgame = game_state.isPawnEndgame();
 
 		// pawn islands
 		const U64 fileset = soutFill(BBs[nWhitePawn + SIDE]) & Constans::r1_rank;
-		eval -= 3 * islandCount(fileset);
+		const int islands = islandCount(fileset);
+		eval += Value::PAWN_ISLAND * islands;
+		Trace::add(Params::PAWN_ISLAND, SIDE, islands);
 
 		bool dist_updated;
 
 		while (pawns) {
 			sq = popLS1B(pawns);
-			eval += Value::position_score[Phase][PAWN][flipSquare<SIDE>(sq)];
+			pst_eval += pstScore<SIDE, Trace>(PAWN, sq);
 			dist_updated = false;
 
 			// if backward pawn...
 			if (!(LookUp::back_file.get(SIDE, sq) & BBs[nWhitePawn + SIDE])) {
-				if constexpr (Phase == gState::ENDGAME) {
+				if constexpr (Phase != gState::OPENING) {
 					eval_vector.t_backw_dist[SIDE] += Value::distance_score.get(sq, eval_vector.k_sq[SIDE]);
 					eval_vector.t_backw_dist[!SIDE] += Value::distance_score.get(sq, eval_vector.k_sq[!SIDE]);
 					eval_vector.backward_count++;
 					dist_updated = true;
 				}
 
-				eval -= 7;
+				eval += Value::BACKWARD_PAWN;
+				Trace::add(Params::BACKWARD_PAWN, SIDE);
 			}
 
 			// if double pawn...
-			if (!(LookUp::sf_file.get(SIDE, sq) & BBs[nWhitePawn + SIDE]))
-				eval -= 10;
+			if (!(LookUp::sf_file.get(SIDE, sq) & BBs[nWhitePawn + SIDE])) {
+				eval += Value::DOUBLED_PAWN;
+				Trace::add(Params::DOUBLED_PAWN, SIDE);
+			}
 			// if passed pawn...
 			else if (!((LookUp::nf_file.get(SIDE, sq) | LookUp::sf_file.get(SIDE, sq)) & BBs[nBlackPawn - SIDE])) {
-				if constexpr (Phase == gState::ENDGAME) {
+				if constexpr (Phase != gState::OPENING) {
 					passed |= bitU64(sq);
 					eval_vector.t_passed_dist[SIDE] += Value::distance_score.get(sq, eval_vector.k_sq[SIDE]);
 					eval_vector.t_passed_dist[!SIDE] += Value::distance_score.get(sq, eval_vector.k_sq[!SIDE]);
@@ -196,17 +409,22 @@ namespace Eval {
 
 				// clear passer square bonus
 				if (!(LookUp::passer_square.get(SIDE, sq) & eval_vector.k_sq[!SIDE])
-					and game_state.turn == SIDE)
+					and game_state.turn == SIDE) {
 					eval += Value::passed_score[flipRank<SIDE>(sq)] / 2 + is_pawn_endgame * 60;
+					Trace::add(Params::PASSED + flipRank<SIDE>(sq), SIDE, .5);
+				}
 
 				eval += Value::passed_score[flipRank<SIDE>(sq)];
+				Trace::add(Params::PASSED + flipRank<SIDE>(sq), SIDE);
 			}
 
 			// if protected...
-			if (bitU64(sq) & p_att or std::get<SIDE>(vertical_pawn_shift)(bitU64(sq)) & p_att)
-				eval += 6;
+			if (bitU64(sq) & p_att or std::get<SIDE>(vertical_pawn_shift)(bitU64(sq)) & p_att) {
+				eval += Value::PROTECTED_PAWN;
+				Trace::add(Params::PROTECTED_PAWN, SIDE);
+			}
 
-			if constexpr (Phase == gState::ENDGAME) {
+			if constexpr (Phase != gState::OPENING) {
 				if (!dist_updated) {
 					eval_vector.t_o_dist[SIDE] += Value::distance_score.get(sq, eval_vector.k_sq[SIDE]);
 					eval_vector.t_o_dist[!SIDE] += Value::distance_score.get(sq, eval_vector.k_sq[!SIDE]);
@@ -215,128 +433,125 @@ namespace Eval {
 		}
 
 		// both defending another pawn bonus
-		eval += 2 * bitCount(PawnAttacks::bothAttackPawn<SIDE>(BBs[nWhitePawn + SIDE], UINT64_MAX));
+		const int chains = bitCount(PawnAttacks::bothAttackPawn<SIDE>(BBs[nWhitePawn + SIDE], UINT64_MAX));
+		eval += Value::PAWN_CHAIN * chains;
+		Trace::add(Params::PAWN_CHAIN, SIDE, chains);
 
 		// save tarrasch masks
-		if constexpr (Phase == gState::ENDGAME) {
+		if constexpr (Phase != gState::OPENING) {
 			eval_vector.tarrasch_passed_msk[SIDE] |= rearspan<SIDE>(passed);
 			eval_vector.tarrasch_passed_msk[!SIDE] |= frontspan<SIDE>(passed);
 		}
 
 		// isolanis and half-isolanis
-		eval -= 8 * bitCount(isolanis(BBs[nWhitePawn + SIDE]))
-			+ 2 * bitCount(halfIsolanis(BBs[nWhitePawn + SIDE]));
-
-		// pawn shield
-		if constexpr (Phase != gState::ENDGAME) {
-			const U64 pshield = std::get<SIDE>(vertical_pawn_shift)(
-				BBs[nWhiteKing + SIDE] | eastOne(BBs[nWhiteKing + SIDE]) | westOne(BBs[nWhiteKing + SIDE])
-				) & BBs[nWhitePawn + SIDE],
-				pshield_front = std::get<SIDE>(vertical_pawn_shift)(pshield) & BBs[nWhitePawn + SIDE];
-			const int pshield_count = bitCount(pshield);
-
-			if (pshield_count == 3)
-				eval += 12;
-			else if (pshield_count == 2 and
-				((pshield << 1) & (pshield >> 1)) == std::get<!SIDE>(vertical_pawn_shift)(pshield_front))
-				eval += 8;
-			else {
-				// penalty for open file near the king
-				eval -= 4 * bitCount(eval_vector.open_files[SIDE] & (eval_vector.k_zone[SIDE] | eval_vector.k_nearby[SIDE]));
-			}
+		const int isolated = bitCount(isolanis(BBs[nWhitePawn + SIDE])),
+			half_isolated = bitCount(halfIsolanis(BBs[nWhitePawn + SIDE]));
+		eval += Value::ISOLATED_PAWN * isolated + Value::HALF_ISOLATED_PAWN * half_isolated;
+		Trace::add(Params::ISOLATED_PAWN, SIDE, isolated);
+		Trace::add(Params::HALF_ISOLATED_PAWN, SIDE, half_isolated);
+
+		// pawn shield - middlegame only
+		const U64 pshield = std::get<SIDE>(vertical_pawn_shift)(
+			BBs[nWhiteKing + SIDE] | eastOne(BBs[nWhiteKing + SIDE]) | westOne(BBs[nWhiteKing + SIDE])
+			) & BBs[nWhitePawn + SIDE],
+			pshield_front = std::get<SIDE>(vertical_pawn_shift)(pshield) & BBs[nWhitePawn + SIDE];
+		const int pshield_count = bitCount(pshield);
+
+		if (pshield_count == 3) {
+			shield_eval = Value::FULL_PAWN_SHIELD;
+			Trace::add(Params::FULL_PAWN_SHIELD, SIDE, 1., 0.);
+		}
+		else if (pshield_count == 2 and
+			((pshield << 1) & (pshield >> 1)) == std::get<!SIDE>(vertical_pawn_shift)(pshield_front)) {
+			shield_eval = Value::PARTIAL_PAWN_SHIELD;
+			Trace::add(Params::PARTIAL_PAWN_SHIELD, SIDE, 1., 0.);
 		}
 		else {
-			// no pawns in endgame penalty
-			eval += !eval_vector.s_pawn_count[SIDE] ? -30 :
+			// penalty for open file near the king
+			const int open_count = bitCount(eval_vector.open_files[SIDE] & (eval_vector.k_zone[SIDE] | eval_vector.k_nearby[SIDE]));
+			shield_eval = Value::OPEN_KING_FILE * open_count;
+			Trace::add(Params::OPEN_KING_FILE, SIDE, open_count, 0.);
+		}
+
+		// no pawns penalty - endgame only
+		if constexpr (Phase != gState::OPENING) {
+			eg_eval = !eval_vector.s_pawn_count[SIDE] ? noPawnsPenalty<SIDE>() :
 				promotionDistanceBonus<SIDE>(BBs[nWhitePawn + SIDE]) * (is_pawn_endgame + 1);
+			Trace::add(Params::NO_PAWNS, SIDE, 0., !eval_vector.s_pawn_count[SIDE]);
 		}
 
 		// overly advanced pawns
-		eval -= 2 * bitCount(overlyAdvancedPawns<SIDE>(BBs[nWhitePawn + SIDE], BBs[nBlackPawn - SIDE]));
+		const int advanced = bitCount(overlyAdvancedPawns<SIDE>(BBs[nWhitePawn + SIDE], BBs[nBlackPawn - SIDE]));
+		eval += Value::OVERLY_ADVANCED_PAWN * advanced;
+		Trace::add(Params::OVERLY_ADVANCED_PAWN, SIDE, advanced);
+
+		Trace::term(Terms::PST, SIDE, pst_eval);
+		Trace::term(Terms::PAWNS, SIDE, Score(eval, eval + eg_eval));
+		Trace::term(Terms::KING_SAFETY, SIDE, Score(shield_eval, 0));
+		return Score(eval + shield_eval, eval + eg_eval) + pst_eval;
+	}
 
-		return eval;
+	// piece evaluation split into terms - piece specific, piece-square, mobility and tropism score
+	template <enumSide SIDE, typename Trace>
+	inline Score pieceTerms(const Score eval, const Score pst_eval, const Score mob_eval, const int trop_eval) {
+		Trace::term(Terms::PIECES, SIDE, eval);
+		Trace::term(Terms::PST, SIDE, pst_eval);
+		Trace::term(Terms::MOBILITY, SIDE, mob_eval);
+		Trace::term(Terms::TROPISM, SIDE, Score(trop_eval, trop_eval));
+		return eval + pst_eval + mob_eval + Score(trop_eval, trop_eval);
 	}
 
 	// evaluation of knights
-	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase>
-	auto pcEval() -> std::enable_if_t<PC == KNIGHT, int> {
-		int sq, eval = 0, mobility;
+	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase, typename Trace>
+	auto pcEval() -> std::enable_if_t<PC == KNIGHT, Score> {
+		int eval = 0, mob_eval = 0, trop_eval = 0;
+		Score pst_eval;
 		const U64 opp_p_att = eval_vector.pt_att[!SIDE][PAWN];
-		U64 k_msk = BBs[nWhiteKnight + SIDE], k_att, safe_att;
 
-		eval_vector.pt_att[SIDE][KNIGHT] = eU64;
+		for (const auto& [sq, mobility, att] : eval_vector.pieces[SIDE][KNIGHT]) {
+			pst_eval += pstScore<SIDE, Trace>(KNIGHT, sq);
 
-		while (k_msk) {
-			sq = popLS1B(k_msk);
-			eval += Value::position_score[Phase][KNIGHT][flipSquare<SIDE>(sq)];
-
-			// safe mobility - do not consider squares controled by enemy pawns
-			k_att = attack<KNIGHT>(UINT64_MAX, sq);
-			safe_att = k_att & ~eval_vector.pt_att[!SIDE][PAWN] & BBs[nEmpty];
-			mobility = bitCount(safe_att);
-			eval += 4 * (mobility - 4);
+			// safe mobility
+			mob_eval += 4 * (mobility - 4);
 			// undefended minor pieces 
-			eval -= 2 * bitCount(~k_att & (BBs[nWhiteKnight + SIDE] | BBs[nWhiteBishop + SIDE]));
-
-			eval_vector.pt_att[SIDE][KNIGHT] |= k_att;
-
-			if constexpr (Phase != gState::ENDGAME) {
-				if (k_att & eval_vector.k_zone[!SIDE]) {
-					eval_vector.att_count[SIDE]++;
-					eval_vector.att_value[SIDE] += Value::attacker_weight[KNIGHT]
-						* bitCount(k_att & eval_vector.k_zone[!SIDE]);
-				}
-				else if (k_att & eval_vector.k_nearby[!SIDE])
-					eval_vector.att_value[SIDE] += Value::attacker_weight[KNIGHT] / 5;
-			}
+			const int undefended = bitCount(~att & (BBs[nWhiteKnight + SIDE] | BBs[nWhiteBishop + SIDE]));
+			eval += Value::UNDEFENDED_MINOR * undefended;
+			Trace::add(Params::UNDEFENDED_MINOR, SIDE, undefended);
 
 			// outpos check
 			if (bitU64(sq) &
-				(Constans::board_side[!SIDE] & eval_vector.pt_att[SIDE][PAWN] & ~opp_p_att))
+				(Constans::board_side[!SIDE] & eval_vector.pt_att[SIDE][PAWN] & ~opp_p_att)) {
 				eval += Value::outpos_score[sq];
+				Trace::add(Params::OUTPOST + sq, SIDE);
+			}
 
 			// king tropism bonus
-			eval += Value::knight_distance_score.get(sq, eval_vector.k_sq[!SIDE])
-				+ eval_vector.pawn_count;
+			trop_eval += Value::knight_distance_score.get(sq, eval_vector.k_sq[!SIDE]);
+			eval += eval_vector.pawn_count;
 		}
 
-		return eval;
+		return pieceTerms<SIDE, Trace>(Score(eval, eval), pst_eval, Score(mob_eval, mob_eval), trop_eval);
 	}
 
 	// evaluation of bishops
-	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase>
-	auto pcEval() -> std::enable_if_t<PC == BISHOP, int> {
-		int sq, eval = 0, b_count = 0, mobility;
-		U64 b_msk = BBs[nWhiteBishop + SIDE], b_att;
-
-		eval_vector.pt_att[SIDE][BISHOP] = eU64;
+	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase, typename Trace>
+	auto pcEval() -> std::enable_if_t<PC == BISHOP, Score> {
+		int eval = 0, mob_eval = 0, trop_eval = 0, b_count = 0;
+		Score pst_eval;
 
-		while (b_msk) {
-			sq = popLS1B(b_msk);
+		for (const auto& [sq, mobility, att] : eval_vector.pieces[SIDE][BISHOP]) {
 			b_count++;
-			eval += Value::position_score[Phase][BISHOP][flipSquare<SIDE>(sq)];
+			pst_eval += pstScore<SIDE, Trace>(BISHOP, sq);
 			
 			// mobility
-			b_att = attack<BISHOP>(BBs[nOccupied], sq);
-			mobility = bitCount(b_att);
-			eval += 3 * (mobility - 7);
+			mob_eval += 3 * (mobility - 7);
 			// undefended minor pieces
-			eval -= 2 * bitCount(~b_att & (BBs[nWhiteKnight + SIDE] | BBs[nWhiteBishop + SIDE]));
-
-			eval_vector.pt_att[SIDE][BISHOP] |= b_att;
-
-			if constexpr (Phase != gState::ENDGAME) {
-				if (b_att & eval_vector.k_zone[!SIDE]) {
-					eval_vector.att_count[SIDE]++;
-					eval_vector.att_value[SIDE] += Value::attacker_weight[BISHOP]
-						* bitCount(b_att & eval_vector.k_zone[!SIDE]);
-				}
-				else if (b_att & eval_vector.k_nearby[!SIDE])
-					eval_vector.att_value[SIDE] += Value::attacker_weight[BISHOP] / 5;
-			}
+			const int undefended = bitCount(~att & (BBs[nWhiteKnight + SIDE] | BBs[nWhiteBishop + SIDE]));
+			eval += Value::UNDEFENDED_MINOR * undefended;
+			Trace::add(Params::UNDEFENDED_MINOR, SIDE, undefended);
 
 			// king tropism score
-			eval += std::max(
+			trop_eval += std::max(
 				Value::adiag_score.get(sq, eval_vector.k_sq[!SIDE]),
 				Value::diag_score.get(sq, eval_vector.k_sq[!SIDE])
 			);
@@ -346,96 +561,70 @@ namespace Eval {
 		}
 
 		// bishop pair bonus
-		eval += (b_count >= 2) * 50;
-		return eval;
+		eval += (b_count >= 2) * Value::BISHOP_PAIR;
+		Trace::add(Params::BISHOP_PAIR, SIDE, b_count >= 2);
+		return pieceTerms<SIDE, Trace>(Score(eval, eval), pst_eval, Score(mob_eval, mob_eval), trop_eval);
 	}
 
 	// evaluation of rooks
-	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase>
-	auto pcEval() -> std::enable_if_t<PC == ROOK, int> {
-		int sq, eval = 0, mobility;
-		U64 r_msk = BBs[nWhiteRook + SIDE], r_att;
+	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase, typename Trace>
+	auto pcEval() -> std::enable_if_t<PC == ROOK, Score> {
+		int eval = 0, mobility_sum = 0, trop_eval = 0, tarrasch_eval = 0;
+		Score pst_eval;
 		
-		static constexpr int mobility_weight = Phase + 1 + (Phase + 1 / 3);
+		static constexpr int mg_mobility_weight = Phase == gState::OPENING ? 1 : 3, eg_mobility_weight = 5;
 
-		eval_vector.pt_att[SIDE][ROOK] = eU64;
-
-		while (r_msk) {
-			sq = popLS1B(r_msk);
-			eval += Value::position_score[Phase][ROOK][flipSquare<SIDE>(sq)];
+		for (const auto& [sq, mobility, att] : eval_vector.pieces[SIDE][ROOK]) {
+			pst_eval += pstScore<SIDE, Trace>(ROOK, sq);
 			
 			// mobility
-			r_att = attack<ROOK>(BBs[nOccupied], sq);
-			mobility = bitCount(r_att);
-			eval += mobility_weight * (mobility - 7);
-
-			eval_vector.pt_att[SIDE][ROOK] |= r_att;
-
-			if constexpr (Phase != gState::ENDGAME) {
-				if (r_att & eval_vector.k_zone[!SIDE]) {
-					eval_vector.att_count[SIDE]++;
-					eval_vector.att_value[SIDE] += Value::attacker_weight[ROOK]
-						* bitCount(r_att & eval_vector.k_zone[!SIDE]);
-				}
-				else if (r_att & eval_vector.k_nearby[!SIDE])
-					eval_vector.att_value[SIDE] += Value::attacker_weight[ROOK] / 5;
-			}
+			mobility_sum += mobility - 7;
 
 			// king tropism score
-			eval += Value::distance_score.get(sq, eval_vector.k_sq[!SIDE]);
+			trop_eval += Value::distance_score.get(sq, eval_vector.k_sq[!SIDE]);
 
 			// open file score
-			if (bitU64(sq) & eval_vector.open_files[SIDE])
-				eval += 10;
+			if (bitU64(sq) & eval_vector.open_files[SIDE]) {
+				eval += Value::ROOK_OPEN_FILE;
+				Trace::add(Params::ROOK_OPEN_FILE, SIDE);
+			}
 			// queen/rook on the same file
-			if (Constans::f_by_index[sq % 8] & (BBs[nBlackQueen - SIDE] | BBs[nWhiteRook + SIDE]))
-				eval += 10;
-			// tarrasch rule
-			if constexpr (Phase == gState::ENDGAME) {
-				if (bitU64(sq) & eval_vector.tarrasch_passed_msk[SIDE])
-					eval += 10;
+			if (Constans::f_by_index[sq % 8] & (BBs[nBlackQueen - SIDE] | BBs[nWhiteRook + SIDE])) {
+				eval += Value::ROOK_QUEEN_FILE;
+				Trace::add(Params::ROOK_QUEEN_FILE, SIDE);
+			}
+			// tarrasch rule - endgame only
+			if constexpr (Phase != gState::OPENING) {
+				if (bitU64(sq) & eval_vector.tarrasch_passed_msk[SIDE]) {
+					tarrasch_eval += Value::TARRASCH_ROOK;
+					Trace::add(Params::TARRASCH_ROOK, SIDE, 0., 1.);
+				}
 			}
 
 			// rook's value increasing as number of pawns is decreasing
 			eval -= eval_vector.pawn_count;
 		}
 
-		return eval;
+		return pieceTerms<SIDE, Trace>(Score(eval, eval + tarrasch_eval), pst_eval,
+			Score(mg_mobility_weight * mobility_sum, eg_mobility_weight * mobility_sum), trop_eval);
 	}
 
 	// evaluation of queens
-	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase>
-	auto pcEval() -> std::enable_if_t<PC == QUEEN, int> {
-		int sq, eval = 0, mobility;
-		U64 q_msk = BBs[nWhiteQueen + SIDE], q_att;
+	template <enumSide SIDE, enumPiece PC, gState::gPhase Phase, typename Trace>
+	auto pcEval() -> std::enable_if_t<PC == QUEEN, Score> {
+		int mobility_sum = 0, trop_eval = 0, dev_eval = 0;
+		Score pst_eval;
 		
-		static constexpr int mobility_weight = (Phase + 2) / 2;
+		static constexpr int mg_mobility_weight = 1, eg_mobility_weight = 2;
 
-		eval_vector.pt_att[SIDE][QUEEN] = eU64;
-
-		while (q_msk) {
-			sq = popLS1B(q_msk);
-			eval += Value::position_score[Phase][QUEEN][flipSquare<SIDE>(sq)];
+		for (const auto& [sq, mobility, att] : eval_vector.pieces[SIDE][QUEEN]) {
+			pst_eval += pstScore<SIDE, Trace>(QUEEN, sq);
 	
 			// mobility
-			q_att = attack<QUEEN>(BBs[nOccupied], sq);
-			mobility = bitCount(q_att);
-			eval += mobility_weight * (mobility - 14);
-
-			eval_vector.pt_att[SIDE][QUEEN] |= q_att;
-
-			if constexpr (Phase != gState::ENDGAME) {
-				if (q_att & eval_vector.k_zone[!SIDE]) {
-					eval_vector.att_count[SIDE]++;
-					eval_vector.att_value[SIDE] += Value::attacker_weight[QUEEN]
-						* bitCount(q_att & eval_vector.k_zone[!SIDE]);
-				}
-				else if (q_att & eval_vector.k_nearby[!SIDE])
-					eval_vector.att_value[SIDE] += Value::attacker_weight[QUEEN] / 5;
-			}
+			mobility_sum += mobility - 14;
 
 			// king tropism score
-			eval += Value::distance_score.get(sq, eval_vector.k_sq[!SIDE])
+			trop_eval += Value::distance_score.get(sq, eval_vector.k_sq[!SIDE])
 				+ std::max(
 					Value::adiag_score.get(sq, eval_vector.k_sq[!SIDE]),
 					Value::diag_score.get(sq, eval_vector.k_sq[!SIDE])
@@ -443,39 +632,65 @@ namespace Eval {
 
 			// penalty for queen development in opening
 			if constexpr (Phase == gState::OPENING)
-				eval += Value::queen_ban_dev[flipSquare<SIDE>(sq)];
+				dev_eval += Value::queen_ban_dev[flipSquare<SIDE>(sq)];
 		}
 
-		return eval;
+		return pieceTerms<SIDE, Trace>(Score(dev_eval, 0), pst_eval,
+			Score(mg_mobility_weight * mobility_sum, eg_mobility_weight * mobility_sum), trop_eval);
 	}
 
-	// king evaluation
-	template <enumSide SIDE, gState::gPhase Phase>
-	int kingEval(int relative_eval) {
+	// king evaluation - relative endgame score decides about king distance bonus
+	template <enumSide SIDE, gState::gPhase Phase, typename Trace>
+	Score kingEval(int relative_eg_eval) {
 		// king zone control
 		const int k_zone_control = eval_vector.att_value[SIDE] * Value::attack_count_weight[eval_vector.att_count[SIDE]] / 120;
-		int eval = k_zone_control;
-
-		if constexpr (Phase != gState::ENDGAME) {
-			eval += Value::king_score[flipSquare<SIDE>(eval_vector.k_sq[SIDE])];
+		int castle_eval = 0, trop_eval = 0;
+		Trace::add(Params::KING_ATTACK + eval_vector.att_count[SIDE], SIDE, eval_vector.att_value[SIDE] / 120.);
 
-			// check castling possibility
-			if constexpr (Phase == gState::OPENING)
-				if (isCastle<SIDE>()) eval += 15;
-		}
-		else {
-			// king distance consideration
-			if (relative_eval > 70)
-				eval += 2 * Value::distance_score.get(eval_vector.k_sq[SIDE], eval_vector.k_sq[!SIDE]);
-			eval += Value::late_king_score[flipSquare<SIDE>(eval_vector.k_sq[SIDE])];
+		// check castling possibility
+		if constexpr (Phase == gState::OPENING) {
+			if (isCastle<SIDE>()) {
+				castle_eval = Value::CASTLE_BONUS;
+				Trace::add(Params::CASTLE_BONUS, SIDE, 1., 0.);
+			}
 		}
+		// king distance consideration
+		else if (relative_eg_eval > 70)
+			trop_eval = 2 * Value::distance_score.get(eval_vector.k_sq[SIDE], eval_vector.k_sq[!SIDE]);
 
-		return eval;
+		const Score safety_eval(k_zone_control + castle_eval, k_zone_control),
+			pst_eval = pstScore<SIDE, Trace>(KING, eval_vector.k_sq[SIDE]);
+
+		Trace::term(Terms::KING_SAFETY, SIDE, safety_eval);
+		Trace::term(Terms::PST, SIDE, pst_eval);
+		Trace::term(Terms::TROPISM, SIDE, Score(0, trop_eval));
+
+		return safety_eval + pst_eval + Score(0, trop_eval);
 	}
 
-	template <enumSide SIDE, gState::gPhase Phase>
+	// weight of endgame score - 0 (all pieces on board) to 256 (bare kings)
+	inline int taperPhase() {
+		return ((8150 - (game_state.material[0] + game_state.material[1] - Value::DOUBLE_KING_VAL)) * 256 + 4075) / 8150;
+	}
+
+	// single pass evaluation - in opening middlegame score alone is used, in later
+	// phases the score is tapered between middlegame and endgame halves
+	template <enumSide SIDE, gState::gPhase Phase, typename Trace>
 	int templEval(int alpha, int beta) {
-		const int material_sc = game_state.material[SIDE] - game_state.material[!SIDE];
+		const int material_sc = game_state.material[SIDE] - game_state.material[!SIDE],
+			phase = Phase == gState::OPENING ? 0 : taperPhase();
+
+		Trace::scale((256 - phase) / 256., phase / 256.);
+
+		for (int pc = PAWN; pc <= QUEEN; pc++) {
+			Trace::add(Params::MATERIAL + pc, WHITE, BBs.count(nWhitePawn + 2 * pc));
+			Trace::add(Params::MATERIAL + pc, BLACK, BBs.count(nBlackPawn + 2 * pc));
+		}
+
+		const int white_material = game_state.material[WHITE] - Value::KING_VALUE,
+			black_material = game_state.material[BLACK] - Value::KING_VALUE;
+		Trace::term(Terms::MATERIAL, WHITE, Score(white_material, white_material));
+		Trace::term(Terms::MATERIAL, BLACK, Score(black_material, black_material));
 
 		if constexpr (Phase == gState::OPENING) {
 			static constexpr int lazy_margin_op = 450;
@@ -486,50 +701,187 @@ namespace Eval {
 				return alpha;
 		}
 
+		eval_vector.attackMapsReset();
+
 		// pawn structure evaluation
-		int eval = pawnStructureEval<SIDE, Phase>() - pawnStructureEval<!SIDE, Phase>();
+		Score eval = pawnStructureEval<SIDE, Phase, Trace>() - pawnStructureEval<!SIDE, Phase, Trace>();
 
-		if constexpr (Phase == gState::ENDGAME)
-			eval += kingPawnTropism<SIDE>() - kingPawnTropism<!SIDE>();
+		if constexpr (Phase != gState::OPENING)
+			eval += Score(0, kingPawnTropism<SIDE, Trace>() - kingPawnTropism<!SIDE, Trace>());
 
-		eval += pcEval<SIDE, KNIGHT, Phase>() - pcEval<!SIDE, KNIGHT, Phase>();
-		eval += pcEval<SIDE, BISHOP, Phase>() - pcEval<!SIDE, BISHOP, Phase>();
-		eval += pcEval<SIDE, ROOK, Phase>() - pcEval<!SIDE, ROOK, Phase>();
-		eval += pcEval<SIDE, QUEEN, Phase>() - pcEval<!SIDE, QUEEN, Phase>();
+		eval += pcEval<SIDE, KNIGHT, Phase, Trace>() - pcEval<!SIDE, KNIGHT, Phase, Trace>();
+		eval += pcEval<SIDE, BISHOP, Phase, Trace>() - pcEval<!SIDE, BISHOP, Phase, Trace>();
+		eval += pcEval<SIDE, ROOK, Phase, Trace>() - pcEval<!SIDE, ROOK, Phase, Trace>();
+		eval += pcEval<SIDE, QUEEN, Phase, Trace>() - pcEval<!SIDE, QUEEN, Phase, Trace>();
 
 		eval +=
 			// consider connectivity (double connected squares)			
-			connectivity<SIDE, Phase>() - connectivity<!SIDE, Phase>()
+			connectivity<SIDE, Trace>() - connectivity<!SIDE, Trace>()
 			// material score and mobility
-			+ material_sc;
+			+ Score(material_sc, material_sc);
 
 		// king position evaluation
-		eval += kingEval<SIDE, Phase>(eval) - kingEval<!SIDE, Phase>(-eval);
-		return eval;
+		eval += kingEval<SIDE, Phase, Trace>(eval.eg()) - kingEval<!SIDE, Phase, Trace>(-eval.eg());
+
+		if constexpr (Phase == gState::OPENING)
+			return eval.mg();
+
+		// middlegame and endgame point of view score interpolation
+		return ((eval.mg() * (256 - phase)) + (eval.eg() * phase)) / 256;
 	}
 
-	template <gState::gPhase Phase>
+	template <gState::gPhase Phase, typename Trace>
 	inline int sideEval(int alpha, int beta) {
 		return game_state.turn == WHITE ?
-			templEval<WHITE, Phase>(alpha, beta) :
-			templEval<BLACK, Phase>(alpha, beta);
+			templEval<WHITE, Phase, Trace>(alpha, beta) :
+			templEval<BLACK, Phase, Trace>(alpha, beta);
 	}
 
-	// main evaluation system
-	int evaluate(int alpha, int beta) {
+	// king and pawn vs king - exact result taken from bitbase
+	inline int kpkEval() {
+		const bool strong = BBs[nBlackPawn] != eU64;
+
+		// normalize position - pawn side is white and pawn stands on a-d files
+		const int flip_rank = strong == BLACK ? 56 : 0;
+		int wksq = getLS1BIndex(BBs[nWhiteKing + strong]) ^ flip_rank,
+			bksq = getLS1BIndex(BBs[nBlackKing - strong]) ^ flip_rank,
+			psq = getLS1BIndex(BBs[nWhitePawn + strong]) ^ flip_rank;
+
+		if ((psq & 7) > 3)
+			wksq ^= 7, bksq ^= 7, psq ^= 7;
+
+		if (!Bitbases::probeKPK(wksq, psq, bksq, game_state.turn != strong))
+			return mSearch::draw_score;
+
+		const int score = Value::KNOWN_WIN + Value::PAWN_VALUE * (psq >> 3);
+		return game_state.turn == strong ? score : -score;
+	}
+
+	// evaluation of game phases - opening or tapered middlegame and endgame
+	template <typename Trace>
+	int phaseEval(int alpha, int beta) {
 		eval_vector.openingDataReset();
 		
 		if (game_state.gamePhase() == gState::OPENING)
-			return sideEval<gState::OPENING>(alpha, beta);
+			return sideEval<gState::OPENING, Trace>(alpha, beta);
 
 		eval_vector.endgameDataReset();
+		return sideEval<gState::MIDDLEGAME, Trace>(alpha, beta);
+	}
 
-		// middlegame and endgame point of view score interpolation
-		const int phase = ((8150 - (game_state.material[0] + game_state.material[1] - Value::DOUBLE_KING_VAL)) * 256 + 4075) / 8150,
-			mid_score = sideEval<gState::MIDDLEGAME>(alpha, beta),
-			end_score = sideEval<gState::ENDGAME>(alpha, beta);
+	// main evaluation system
+	int evaluate(int alpha, int beta) {
+		if (bitCount(BBs[nOccupied]) == 3 and (BBs[nWhitePawn] | BBs[nBlackPawn]))
+			return kpkEval();
+
+		return phaseEval<NoTrace>(alpha, beta);
+	}
+
+} // namespace Eval
+
+int Eval::Params::trace(Coefficients& coef) {
+	coef.fill(0.);
+	LinearTrace::coef = &coef;
+
+	// full score is needed - no lazy cutoffs, bitbase scores have no parameters
+	const int score = bitCount(BBs[nOccupied]) == 3 and (BBs[nWhitePawn] | BBs[nBlackPawn]) ?
+		kpkEval() : phaseEval<LinearTrace>(-INT32_MAX, INT32_MAX);
+
+	LinearTrace::coef = nullptr;
+	return game_state.turn == WHITE ? score : -score;
+}
+
+void Eval::printTrace(std::ostream& out) {
+	if (bitCount(BBs[nOccupied]) == 3 and (BBs[nWhitePawn] | BBs[nBlackPawn])) {
+		out << "KPK bitbase score: " << kpkEval() << " (side to move)\n\n";
+		return;
+	}
+
+	Terms::Table table{};
+	TermTrace::table = &table;
+	const int score = phaseEval<TermTrace>(-INT32_MAX, INT32_MAX);
+	TermTrace::table = nullptr;
+
+	// opening is evaluated with middlegame score alone
+	const bool opening = game_state.gamePhase() == gState::OPENING;
+	const std::vector<int> halves = opening ? std::vector<int>{ 0 } : std::vector<int>{ 0, 1 };
+	const std::array<const char*, 2> half_names = { opening ? "op" : "mg", "eg" };
+
+	const auto row = [&out, &halves](const char* name, const auto& value) {
+		out << std::setw(14) << name;
+		for (int col = 0; col < 3; col++) {
+			out << " |";
+			for (const int h : halves)
+				out << std::setw(7) << value(col, h);
+		}
+		out << '\n';
+	};
+
+	out << std::setw(14) << "term";
+	for (const char* col : { "white", "black", "total" }) {
+		out << " |" << std::setw(7) << col;
+		for (size_t i = 1; i < halves.size(); i++) out << std::setw(7) << ' ';
+	}
+	out << '\n';
+
+	row("", [&half_names](int, int h) { return half_names[h]; });
+	out << std::string(14 + 3 * (2 + 7 * halves.size()), '-') << '\n';
+
+	std::array<std::array<int, 2>, 2> sums{};
+
+	for (int t = 0; t < Terms::COUNT; t++) {
+		row(Terms::names[t], [&table, t](int col, int h) {
+			return col < 2 ? table[t][col][h] : table[t][WHITE][h] - table[t][BLACK][h];
+		});
+
+		for (const int h : halves)
+			sums[WHITE][h] += table[t][WHITE][h], sums[BLACK][h] += table[t][BLACK][h];
+	}
 
-		return ((mid_score * (256 - phase)) + (end_score * phase)) / 256;
+	out << std::string(14 + 3 * (2 + 7 * halves.size()), '-') << '\n';
+	row("total", [&sums](int col, int h) {
+		return col < 2 ? sums[col][h] : sums[WHITE][h] - sums[BLACK][h];
+	});
+
+	if (!opening)
+		out << "\nphase: " << taperPhase() << "/256 endgame";
+
+	out << "\nevaluation: " << (game_state.turn == WHITE ? score : -score) << " (white side), "
+		<< score << " (side to move)\n\n";
+}
+
+void Eval::kpkTest(std::ostream& out) {
+	// won for the pawn side or drawn - both colors, sides of the board and sides to move
+	static constexpr struct { const char* fen; bool win; } known[] = {
+		{ "4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", true },    // king on the sixth in front of pawn
+		{ "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", true },
+		{ "8/4k3/8/4K3/4P3/8/8/8 b - - 0 1", true },    // white has the opposition
+		{ "8/4k3/8/4K3/4P3/8/8/8 w - - 0 1", false },   // black has the opposition
+		{ "8/8/8/4p3/4k3/8/4K3/8 w - - 0 1", true },    // the same with colors swapped
+		{ "8/8/8/4p3/4k3/8/4K3/8 b - - 0 1", false },
+		{ "k7/8/8/8/8/8/P7/K7 w - - 0 1", false },      // rook pawn with defending king in the corner
+		{ "k7/p7/8/8/8/8/8/K7 b - - 0 1", false },
+		{ "8/8/8/4k3/4P3/8/8/7K w - - 0 1", false },    // pawn is lost
+		{ "5k2/5P2/5K2/8/8/8/8/8 b - - 0 1", false },   // stalemate
+		{ "8/8/8/2k5/7P/8/8/K7 w - - 0 1", true },      // king outside the square of the pawn
+		{ "8/8/8/3k4/7P/8/8/K7 b - - 0 1", false },     // king steps into the square
+	};
+
+	int passed = 0;
+	for (const auto& pos : known) {
+		BBs.parseFEN(pos.fen);
+
+		// evaluation is relative to the side to move
+		const bool pawn_side = BBs[nBlackPawn] != eU64;
+		const int score = evaluate(mSearch::low_bound, mSearch::high_bound),
+			expected = !pos.win ? mSearch::draw_score : game_state.turn == pawn_side ? Value::KNOWN_WIN : -Value::KNOWN_WIN;
+
+		if (pos.win ? (expected > 0 ? score >= expected : score <= expected) : score == expected)
+			passed++;
+		else
+			out << "KPK mismatch: " << pos.fen << " score " << score << " expected " << (pos.win ? "win" : "draw") << '\n';
 	}
 
-} // namespace Eval
\ No newline at end of file
+	out << "KPK positions: " << passed << '/' << std::size(known) << '\n';
+	BBs.parseFEN(BitBoardsSet::start_pos);
+}
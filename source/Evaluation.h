@@ -1,8 +1,9 @@
 #pragma once
 
 #include "BitBoardsSet.h"
-#include "StaticLookup.h"
+#include "staticLookup.h"
 #include "LegalityTest.h"
+#include <ostream>
 
 
 namespace Eval {
@@ -74,6 +75,9 @@ namespace Eval {
 			PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE,
 		};
 
+		// score of won endgames known from bitbases, raised by pawn advancement so that search makes progress
+		static constexpr int KNOWN_WIN = 10000;
+
 		enum {
 			PASSER_WEIGHT = 6,
 			BACKWARD_WEIGHT = 3,
@@ -311,8 +315,78 @@ namespace Eval {
 			QUEEN_ATTACK = 1,
 		};
 
+		enum pawnStructureWeight {
+			PAWN_ISLAND = -3,
+			BACKWARD_PAWN = -7,
+			DOUBLED_PAWN = -10,
+			PROTECTED_PAWN = 6,
+			PAWN_CHAIN = 2,
+			ISOLATED_PAWN = -8,
+			HALF_ISOLATED_PAWN = -2,
+			OVERLY_ADVANCED_PAWN = -2,
+			NO_PAWNS = -30,
+			FULL_PAWN_SHIELD = 12,
+			PARTIAL_PAWN_SHIELD = 8,
+			OPEN_KING_FILE = -4
+		};
+
+		enum pieceWeight {
+			UNDEFENDED_MINOR = -2,
+			BISHOP_PAIR = 50,
+			ROOK_OPEN_FILE = 10,
+			ROOK_QUEEN_FILE = 10,
+			TARRASCH_ROOK = 10,
+			CASTLE_BONUS = 15
+		};
+
 	} // namespace Value
 
+	// tunable evaluation parameters as a single vector - tables are laid out as in Value namespace,
+	// scalar weights follow the Value enums of the same name
+	namespace Params {
+
+		enum Index : int {
+			MATERIAL = 0,                   // pawn to queen
+			PST_MG = MATERIAL + 5,          // opening and middlegame piece-square tables, pawn to king
+			PST_EG = PST_MG + 6 * 64,       // endgame piece-square tables
+			PASSED = PST_EG + 6 * 64,       // passed_score
+			OUTPOST = PASSED + 7,           // outpos_score
+			KING_ATTACK = OUTPOST + 64,     // attack_count_weight
+			PAWN_ISLAND = KING_ATTACK + 11,
+			BACKWARD_PAWN,
+			DOUBLED_PAWN,
+			PROTECTED_PAWN,
+			PAWN_CHAIN,
+			ISOLATED_PAWN,
+			HALF_ISOLATED_PAWN,
+			OVERLY_ADVANCED_PAWN,
+			NO_PAWNS,
+			FULL_PAWN_SHIELD,
+			PARTIAL_PAWN_SHIELD,
+			OPEN_KING_FILE,
+			UNDEFENDED_MINOR,
+			BISHOP_PAIR,
+			ROOK_OPEN_FILE,
+			ROOK_QUEEN_FILE,
+			TARRASCH_ROOK,
+			CASTLE_BONUS,
+			ENDGAME_PAWN_ATTACK,
+			PAWN_ATTACK,
+			MINOR_ATTACK,
+			ROOK_ATTACK,
+			QUEEN_ATTACK,
+			COUNT
+		};
+
+		// coefficient of every parameter in the white relative score
+		using Coefficients = std::array<double, COUNT>;
+
+		// evaluate current position and collect coefficients of the parameters, score is white relative -
+		// remaining terms (mobility, tropism, interpolation rounding...) are left out of the coefficients
+		int trace(Coefficients& coef);
+
+	} // namespace Params
+
 	// simple version of evaluation funcion
 	inline int simpleEvaluation() {
 		return Value::PAWN_VALUE * (BBs.count(nWhitePawn + game_state.turn) - BBs.count(nBlackPawn - game_state.turn));
@@ -321,4 +395,10 @@ namespace Eval {
 	// main evaluation system
 	int evaluate(int alpha, int beta);
 
+	// score of every evaluation term per side and game phase for current position
+	void printTrace(std::ostream& out);
+
+	// bitbase evaluation of known king and pawn vs king positions, current position is reset to the start position
+	void kpkTest(std::ostream& out);
+
 } // namespace Eval
\ No newline at end of file
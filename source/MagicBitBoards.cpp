@@ -20,10 +20,10 @@ void InitState::initMAttacksTables() {
                 subset = indexSubsetU64(i, att, n);
 
                 if (r)
-                    mdata.mRookAtt[sq][mIndexHash(subset, mTabs::mRook[sq], n)]
+                    mdata.mRookAtt[sq][slidingIndex<ROOK>(subset, sq)]
                     = attackSquaresRook(subset, sq);
                 else
-                    mdata.mBishopAtt[sq][mIndexHash(subset, mTabs::mBishop[sq], n)]
+                    mdata.mBishopAtt[sq][slidingIndex<BISHOP>(subset, sq)]
                     = attackSquaresBishop(subset, sq);
             }
         }
@@ -108,6 +108,22 @@ namespace {
 } // namespace
 
 
+// index of sliding piece attacks look-up table entry -
+// with BMI2 avaible use parallel bits extraction instead of magic multiplication
+template <enumPiece pT>
+inline int slidingIndex(U64 occ, int sq) noexcept {
+    static_assert(pT == BISHOP or pT == ROOK, "Unsupported piece type by slidingIndex function");
+
+#if defined(USE_PEXT)
+    return static_cast<int>(_pext_u64(occ, pT == ROOK ? mTabs::rRook[sq] : mTabs::rBishop[sq]));
+#else
+    if constexpr (pT == ROOK)
+        return mIndexHash(occ & mTabs::rRook[sq], mTabs::mRook[sq], mTabs::rbRook[sq]);
+    return mIndexHash(occ & mTabs::rBishop[sq], mTabs::mBishop[sq], mTabs::rbBishop[sq]);
+#endif
+}
+
+
 // InitState namespace contains program init functions which needs to be called
 // when the program starts
 namespace InitState {
@@ -141,13 +157,13 @@ inline U64 attack<KNIGHT>(U64, int sq) noexcept {
 template <>
 inline U64 attack<BISHOP>(U64 occ, int sq) noexcept {
     assert(sq >= 0 and sq < 64 && "Index overflow");
-    return mdata.mBishopAtt[sq][mIndexHash(occ & mTabs::rBishop[sq], mTabs::mBishop[sq], mTabs::rbBishop[sq])];
+    return mdata.mBishopAtt[sq][slidingIndex<BISHOP>(occ, sq)];
 }
 
 template <>
 inline U64 attack<ROOK>(U64 occ, int sq) noexcept {
     assert(sq >= 0 and sq < 64 && "Index overflow");
-    return mdata.mRookAtt[sq][mIndexHash(occ & mTabs::rRook[sq], mTabs::mRook[sq], mTabs::rbRook[sq])];
+    return mdata.mRookAtt[sq][slidingIndex<ROOK>(occ, sq)];
 }
 
 template <>
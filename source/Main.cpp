@@ -7,6 +7,11 @@
 #include "SearchBenchmark.h"
 #include "Zobrist.h"
 #include "Evaluation.h"
+#include "MoveGeneration.h"
+#include "Bitbase.h"
+#include "Batch.h"
+#include "SelfPlay.h"
+#include "Tuner.h"
 
 Zobrist hash;
 BitBoardsSet BBs(BitBoardsSet::start_pos);
@@ -24,5 +29,72 @@ mSearch m_search;
 
 int main(int argc, char* argv[]) {
 	InitState::initMAttacksTables();
+	InitState::initCuckooTables();
+	InitState::initReductionsTable();
+	InitState::initBitbases();
+
+	// command line bench: ./austerlitz bench [depth] [hashMB] [threads]
+	if (argc > 1 and std::string(argv[1]) == "bench") {
+		std::istringstream args;
+		std::string line;
+
+		for (int i = 2; i < argc; i++)
+			line += std::string(argv[i]) + ' ';
+
+		args.str(line);
+		bench.run(args);
+		return 0;
+	}
+	// command line perft: ./austerlitz perft <depth> [fen]
+	else if (argc > 2 and std::string(argv[1]) == "perft") {
+		std::string fen;
+
+		for (int i = 3; i < argc; i++)
+			fen += std::string(argv[i]) + ' ';
+
+		if (!fen.empty())
+			BBs.parseFEN(fen);
+
+		MoveGenerator::Analisis::perftDriver(std::stoi(argv[2]));
+		return 0;
+	}
+	// command line batch analysis: ./austerlitz batch <file> [depth|nodes|movetime N] [workers N] [hash MB] [format csv|jsonl]
+	// and EPD test suite: ./austerlitz epdtest <file> [movetime|nodes|depth N]
+	else if (argc > 2 and (std::string(argv[1]) == "batch" or std::string(argv[1]) == "epdtest")) {
+		std::istringstream args;
+		std::string line;
+
+		for (int i = 2; i < argc; i++)
+			line += std::string(argv[i]) + ' ';
+
+		args.str(line);
+		std::string(argv[1]) == "batch" ? Batch::run(args) : Batch::epdTest(args);
+		return 0;
+	}
+	// command line self-play match: ./austerlitz selfplay [openings <file>] [games N] [workers N] [nodes|movetime N | tc base inc] ...
+	else if (argc > 1 and std::string(argv[1]) == "selfplay") {
+		std::istringstream args;
+		std::string line;
+
+		for (int i = 2; i < argc; i++)
+			line += std::string(argv[i]) + ' ';
+
+		args.str(line);
+		SelfPlay::run(args);
+		return 0;
+	}
+	// command line evaluation tuning: ./austerlitz tune <file> [epochs N] [threads N] [rate F] [k F] [report N] [output <file>]
+	else if (argc > 2 and std::string(argv[1]) == "tune") {
+		std::istringstream args;
+		std::string line;
+
+		for (int i = 2; i < argc; i++)
+			line += std::string(argv[i]) + ' ';
+
+		args.str(line);
+		Tuner::run(args);
+		return 0;
+	}
+
 	UCI_o.goLoop(argc, argv);
 }
\ No newline at end of file
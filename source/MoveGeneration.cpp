@@ -17,6 +17,12 @@ namespace pinData {
 
 namespace checkData {
 	U64 legal_squares;
+
+	// quiet checks generation data - squares from which each piece type attacks enemy king,
+	// own pieces uncovering a slider attack on enemy king when moved and enemy king square
+	std::array<U64, 6> check_squares;
+	U64 discoverers;
+	int enemy_king_sq;
 }
 
 
@@ -74,6 +80,38 @@ namespace MoveGenerator {
 		return UINT64_MAX;
 	};
 
+	// prepare check squares and discovered check candidates for quiet checks generation
+	template <enumSide SIDE>
+	void initCheckData() {
+		const int ksq = checkData::enemy_king_sq = getLS1BIndex(BBs[nBlackKing - SIDE]);
+		const U64 own = BBs[nWhite + SIDE],
+			bishop_checks = attack<BISHOP>(BBs[nOccupied], ksq),
+			rook_checks = attack<ROOK>(BBs[nOccupied], ksq);
+
+		checkData::check_squares = {
+			cpawn_attacks[!SIDE][ksq], cknight_attacks[ksq], bishop_checks, rook_checks, bishop_checks | rook_checks, eU64
+		};
+
+		// own sliders hidden behind exactly one own piece on the line to enemy king
+		U64 snipers = (xRayBishopAttack(BBs[nOccupied], own, ksq) & (BBs[nWhiteBishop + SIDE] | BBs[nWhiteQueen + SIDE]))
+			| (xRayRookAttack(BBs[nOccupied], own, ksq) & (BBs[nWhiteRook + SIDE] | BBs[nWhiteQueen + SIDE]));
+
+		checkData::discoverers = eU64;
+		while (snipers)
+			checkData::discoverers |= inBetween(popLS1B(snipers), ksq) & own;
+	}
+
+	// targets of a quiet move giving check - direct check squares of the piece, or any square
+	// off the line between enemy king and the uncovered slider for discovered check candidates
+	template <enumPiece PC, enumSide SIDE>
+	inline U64 checkTargets(int origin) {
+		if (!(bitU64(origin) & checkData::discoverers))
+			return checkData::check_squares[PC];
+
+		const U64 sniper = xRayQueenAttack(BBs[nOccupied], bitU64(origin), checkData::enemy_king_sq) & BBs[nWhite + SIDE];
+		return checkData::check_squares[PC] | ~inBetween(getLS1BIndex(sniper), checkData::enemy_king_sq);
+	}
+
 	// generator functions based on PINNED piece flag -
 	// excluded pieces template parameters don't meet conditions of these functions.
 	template <GenType gType, enumPiece PC, enumSide SIDE, bool Pin, class =
@@ -95,14 +133,17 @@ namespace MoveGenerator {
 			attacks =
 				attack<PC>(BBs[nOccupied], origin) & avaible & sqAvaible<PC, SIDE, Pin>(origin);
 
-			captures = attacks & BBs[nBlack - SIDE];
-			while (captures) {
-				*it++ = MoveItem::encodeQuietCapture<PC, SIDE>(origin, popLS1B(captures), true);
+			if constexpr (gType != QUIET_CHECKS) {
+				captures = attacks & BBs[nBlack - SIDE];
+				while (captures) {
+					*it++ = MoveItem::encodeQuietCapture<PC, SIDE>(origin, popLS1B(captures), true);
+				}
 			}
 
 			// perform quiets
 			if constexpr (gType != CAPTURES and gType != TACTICAL) {
 				quiets = attacks & ~BBs[nBlack - SIDE];
+				if constexpr (gType == QUIET_CHECKS) quiets &= checkTargets<PC, SIDE>(origin);
 
 				while (quiets) {
 					*it++ = MoveItem::encodeQuietCapture<PC, SIDE>(origin, popLS1B(quiets), false);
@@ -188,15 +229,20 @@ namespace MoveGenerator {
 
 				while (single_push) {
 					target = popLS1B(single_push);
+					if (gType == QUIET_CHECKS and !(bitU64(target) & checkTargets<PAWN, SIDE>(target + SingleOff))) continue;
 					*it++ = (MoveItem::encode<MoveItem::encodeType::QUIET>(target + SingleOff, target, PAWN, SIDE));
 				}
 
 				while (double_push) {
 					target = popLS1B(double_push);
+					if (gType == QUIET_CHECKS and !(bitU64(target) & checkTargets<PAWN, SIDE>(target + DoubleOff))) continue;
 					*it++ = (MoveItem::encode<MoveItem::encodeType::DOUBLE_PUSH>(target + DoubleOff, target, PAWN, SIDE));
 				}
 			}
 
+			if constexpr (gType == QUIET_CHECKS)
+				return;
+
 			// processing pawn promotions by captures
 			U64 promote_moves = west_captures & promote_rank_mask;
 			while (promote_moves) {
@@ -288,15 +334,23 @@ namespace MoveGenerator {
 			single_push &= ~promote_rank_mask & checkData::legal_squares;
 			while (single_push) {
 				target = popLS1B(single_push);
+				if (gType == QUIET_CHECKS and !(bitU64(target) & checkTargets<PAWN, SIDE>(target + single_off))) continue;
 				*it++ = (MoveItem::encode<MoveItem::encodeType::QUIET>(target + single_off, target, PAWN, SIDE));
 			}
 
 			while (double_push) {
 				target = popLS1B(double_push);
+				if (gType == QUIET_CHECKS and !(bitU64(target) & checkTargets<PAWN, SIDE>(target + double_off))) continue;
 				*it++ = MoveItem::encode<MoveItem::encodeType::DOUBLE_PUSH>(target + double_off, target, PAWN, SIDE);
 			}
 		}
 
+		// quiet checks - no promotions nor captures, only pinned pawns pushes left
+		if constexpr (gType == QUIET_CHECKS) {
+			if constexpr (!Check) PawnHelpers::diffPawnGenerate<gType, SIDE, single_off, double_off, Check>(it);
+			return;
+		}
+
 		// processing pawn promotions by pushes
 		if constexpr (gType != CAPTURES) {
 			while (promote_moves) {
@@ -345,6 +399,9 @@ namespace MoveGenerator {
 		const U64 checkers = attackTo<SIDE, KING>(pinData::king_sq);
 		const bool check = checkers;
 
+		if constexpr (gType == QUIET_CHECKS)
+			initCheckData<SIDE>();
+
 		// double check case skipping - only king moves to non-attacked squares are permitted
 		// when there is double check situation
 		if (!isDoubleChecked(checkers)) {
@@ -373,6 +430,7 @@ namespace MoveGenerator {
 		bool capture;
 
 		if constexpr (gType == CAPTURES or gType == TACTICAL) king_moves &= BBs[nBlack - SIDE];
+		else if constexpr (gType == QUIET_CHECKS) king_moves &= BBs[nEmpty] & checkTargets<KING, SIDE>(pinData::king_sq);
 		else king_moves &= ~BBs[nWhite + SIDE];
 
 		// loop throught all king possible moves
@@ -387,8 +445,8 @@ namespace MoveGenerator {
 			}
 		}
 
-		// if only captures generated - no need to consider castling
-		if constexpr (gType == CAPTURES or gType == TACTICAL)
+		// if only captures (or quiet checks) generated - no need to consider castling
+		if constexpr (gType == CAPTURES or gType == TACTICAL or gType == QUIET_CHECKS)
 			return;
 		else if (check)
 			return;
@@ -445,6 +503,7 @@ namespace MoveGenerator {
 	template void generateLegalMoves<LEGAL>(MoveList&);
 	template void generateLegalMoves<CAPTURES>(MoveList&);
 	template void generateLegalMoves<TACTICAL>(MoveList&);
+	template void generateLegalMoves<QUIET_CHECKS>(MoveList&);
 
 } // namespace MoveGenerator
 
@@ -652,7 +711,7 @@ namespace MoveGenerator {
 		}
 
 		template <>
-		inline unsigned long long dPerft<0>() noexcept {
+		inline unsigned long long dPerft<0>() {
 			return 1uLL;
 		}
 
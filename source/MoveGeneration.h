@@ -46,9 +46,10 @@ public:
 // move generation resources
 namespace MoveGenerator {
 
-	// generation type for move generator
+	// generation type for move generator - QUIET_CHECKS are non-capturing, non-promoting
+	// moves giving direct or discovered check, generated only when not in check
 	enum GenType {
-		LEGAL, CAPTURES, TACTICAL
+		LEGAL, CAPTURES, TACTICAL, QUIET_CHECKS
 	};
 
 	namespace Analisis {
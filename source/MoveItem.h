@@ -169,7 +169,7 @@ namespace MoveItem {
 
 	// direct function template as a parameter of a specific encoding mode
 	template <encodeType eT>
-	uint32_t encode(int origin, int target, enumPiece piece, enumSide side);
+	uint32_t encode(int origin, int target, enumPiece piece, enumSide side) noexcept;
 
 	template <>
 	inline uint32_t encode<encodeType::QUIET>(int origin, int target, enumPiece piece, enumSide side) noexcept {
@@ -12,83 +12,178 @@ inline size_t leastValuableAtt(U64 att, bool side) {
 	return nEmpty;
 }
 
-// get initial material of piece occuping given square
-inline size_t getCapturedMaterial(int sq) {
-	for (auto pc = nBlackPawn - game_state.turn; pc <= nBlackKing; pc += 2)
-		if (bitU64(sq) & BBs[pc]) return pc;
-
-	// en passant capture scenario
-	static constexpr std::array<int, 2> ep_shift = { Compass::nort, Compass::sout };
-	return (game_state.ep_sq + ep_shift[game_state.turn] == sq) ? (nBlackPawn - game_state.turn) : nEmpty;
+// bishops and queens of both sides
+inline U64 diagonalSliders() {
+	return BBs[nWhiteBishop] | BBs[nBlackBishop] | BBs[nWhiteQueen] | BBs[nBlackQueen];
 }
 
+// rooks and queens of both sides
+inline U64 straightSliders() {
+	return BBs[nWhiteRook] | BBs[nBlackRook] | BBs[nWhiteQueen] | BBs[nBlackQueen];
+}
+
+// all attackers of both sides to given square, with given occupancy
+inline U64 attackersOf(const int sq, const U64 occ) {
+	return (BBs[nWhitePawn] & cpawn_attacks[BLACK][sq])
+		| (BBs[nBlackPawn] & cpawn_attacks[WHITE][sq])
+		| ((BBs[nWhiteKnight] | BBs[nBlackKnight]) & cknight_attacks[sq])
+		| ((BBs[nWhiteKing] | BBs[nBlackKing]) & cking_attacks[sq])
+		| (diagonalSliders() & attack<BISHOP>(occ, sq))
+		| (straightSliders() & attack<ROOK>(occ, sq));
+}
+
+// remove attacker from the exchange and add sliders uncovered behind it - only
+// the line the attacker stood on may open, so a single slider lookup is enough
+inline void removeAttacker(U64& attackers, U64& occ, const U64 att_bb, const size_t att_pc, const int sq) {
+	const enumPiece type = toPieceType(att_pc);
+	occ ^= att_bb;
+
+	if (type == PAWN or type == BISHOP or type == QUEEN)
+		attackers |= attack<BISHOP>(occ, sq) & diagonalSliders();
+	if (type == ROOK or type == QUEEN)
+		attackers |= attack<ROOK>(occ, sq) & straightSliders();
+
+	attackers &= occ;
+}
+
+// occupancy right after the move is made - moved piece on target square, en passant victim removed
+inline U64 exchangeOccupancy(const MoveItem::iMove move) {
+	const int to = move.getTarget();
+	U64 occ = (BBs[nOccupied] ^ bitU64(move.getOrigin())) | bitU64(to);
+
+	if (move.isEnPassant())
+		occ ^= bitU64(to + (move.getSide() ? Compass::nort : Compass::sout));
+
+	return occ;
+}
 
-int mOrder::see(const int sq) {
-	std::array<int, 33> gain;
 
-	bool side = game_state.turn;
-	std::array<U64, 2> attackers;
-	U64 processed = eU64;
+int mOrder::see(const MoveItem::iMove capt) {
+	std::array<int, 32> gain;
 
-	int i = 0;
-	gain[i] = 0;
-	size_t weakest_att = getCapturedMaterial(sq);
-	attackers[side] = attackTo(sq, !side);
+	const int to = capt.getTarget(), promo = capt.getPromo();
+	bool side = capt.getSide();
 
-	while (attackers[side] and weakest_att < nWhiteKing) {
-		i++;
-		gain[i] = -gain[i - 1] + Eval::Value::piece_material[toPieceType(weakest_att)];
+	U64 occ = exchangeOccupancy(capt);
+	U64 attackers = attackersOf(to, occ) & occ;
 
-		weakest_att = leastValuableAtt(attackers[side], side);
-		processed |= bitU64(getLS1BIndex(BBs[weakest_att] & ~processed));
+	// material standing on the target square, exposed to the next capture
+	int on_square = Eval::Value::piece_material[promo ? promo : capt.getPiece()];
+	int d = 0;
+	gain[d] = (capt.isCapture() ? Eval::Value::piece_material[capturedType(capt)] : 0) 
+		+ (promo ? Eval::Value::piece_material[promo] - Eval::Value::PAWN_VALUE : 0);
 
+	while (true) {
 		side = !side;
-		attackers[side] = attackTo(sq, !side, BBs[nOccupied] ^ processed) & ~processed;
+
+		const U64 side_att = attackers & BBs[nWhite + side];
+		if (!side_att)
+			break;
+
+		const size_t att_pc = leastValuableAtt(side_att, side);
+
+		// king can't capture a defended piece
+		if (att_pc >= nWhiteKing and (attackers & BBs[nWhite + !side]))
+			break;
+
+		d++;
+		gain[d] = on_square - gain[d - 1];
+		on_square = Eval::Value::piece_material[toPieceType(att_pc)];
+
+		removeAttacker(attackers, occ, bitU64(getLS1BIndex(BBs[att_pc] & side_att)), att_pc, to);
+	}
+
+	// each side may stop the exchange whenever continuing loses material
+	while (d > 0) {
+		gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+		d--;
 	}
 
-	while (i >= 2) {
-		gain[i - 1] = -std::max(-gain[i - 1], gain[i]);
-		i--;
+	return gain[0];
+}
+
+int mOrder::capturedType(const MoveItem::iMove capt) {
+	const int target = capt.getTarget();
+	const bool side = capt.getSide();
+
+	if (capt.isEnPassant())
+		return PAWN;
+
+	for (auto pc = nBlackPawn - side; pc <= nBlackQueen; pc += 2)
+		if (getBit(BBs[pc], target)) return toPieceType(pc);
+
+	return PAWN;
+}
+
+bool mOrder::see_ge(const MoveItem::iMove move, const int threshold) {
+	const int to = move.getTarget(), promo = move.getPromo();
+	bool side = move.getSide();
+
+	// gain of the first capture (and promotion) has to reach the threshold
+	int balance = (move.isCapture() ? Eval::Value::piece_material[capturedType(move)] : 0)
+		+ (promo ? Eval::Value::piece_material[promo] - Eval::Value::PAWN_VALUE : 0) - threshold;
+	if (balance < 0)
+		return false;
+
+	// even losing moved piece for nothing keeps the threshold
+	balance = Eval::Value::piece_material[promo ? promo : move.getPiece()] - balance;
+	if (balance <= 0)
+		return true;
+
+	U64 occ = exchangeOccupancy(move);
+	U64 attackers = attackersOf(to, occ) & occ;
+
+	// res - whether the side which made the move wins (1) or not (0) with the current exchange state
+	bool res = true;
+
+	while (true) {
+		side = !side;
+
+		const U64 side_att = attackers & BBs[nWhite + side];
+		if (!side_att)
+			break;
+
+		res = !res;
+		const size_t att_pc = leastValuableAtt(side_att, side);
+
+		// king can't capture a defended piece
+		if (att_pc >= nWhiteKing) {
+			if (attackers & BBs[nWhite + !side])
+				res = !res;
+			break;
+		}
+
+		// balance is negated each capture - stop if the capturing side stays behind even after winning the piece
+		if ((balance = Eval::Value::piece_material[toPieceType(att_pc)] - balance) < res)
+			break;
+
+		removeAttacker(attackers, occ, bitU64(getLS1BIndex(BBs[att_pc] & side_att)), att_pc, to);
 	}
 
-	return gain[1];
+	return res;
 }
 
 // evaluate move
 int mOrder::moveScore(
-	const MoveItem::iMove move, const int ply, const int depth, 
-	const MoveItem::iMove tt_move, const MoveItem::iMove prev_move
+	const MoveItem::iMove move, const int ply, const int depth, const MoveItem::iMove tt_move, 
+	const MoveItem::iMove prev_move, const MoveItem::iMove prev2_move
 ) {
-	const int target = move.getTarget();
-
 	// PV move detected
 	if (move == tt_move)
 		return HASH_SCORE;
 	// distinguish between quiets and captures
 	else if (move.isCapture()) {
+		const int victim = capturedType(move), history_bonus = captureHistoryScore(move, victim);
+
 		// evaluate good and equal captures at depth >= 5 slightly above killer moves,
 		// but keep bad captures scoring less than killers
 		if (depth >= 5) 
-			return seeScore(move);
-		else if (move.isEnPassant()) 
-			return mvv_lva[PAWN][PAWN];
-
-		const int att = move.getPiece();
-		int victim;
-		const bool side = move.getSide();
-
-		// find victim piece
-		for (auto pc = nBlackPawn - side; pc <= nBlackQueen; pc += 2) {
-			if (getBit(BBs[pc], target)) {
-				victim = toPieceType(pc);
-				break;
-			}
-		}
+			return seeScore(move) + history_bonus;
 
 		// recapture moves are treated slightly better than same victim-attacker captures
 		const int recapture_bonus = recaptureBonus(move, prev_move);
 
-		return mvv_lva[att][victim] + recapture_bonus;
+		return mvv_lva[move.getPiece()][victim] + recapture_bonus + history_bonus;
 	}
 
 	if (move == killer[0][ply])
@@ -98,20 +193,20 @@ int mOrder::moveScore(
 	else if (move.getPromo())
 		return promotionScore(move);
 
-	return quietScore(move, prev_move, target, ply);
+	return quietScore(move, prev_move, prev2_move);
 }
 
 // pick best based on normal moveScore() eval function
 int mOrder::pickBest(
-	MoveList& move_list, const int s, const int ply, 
-	const int depth, const MoveItem::iMove prev_move
+	MoveList& move_list, const int s, const int ply, const int depth, 
+	const MoveItem::iMove prev_move, const MoveItem::iMove prev2_move
 ) {
 	static MoveItem::iMove tmp;
 	const MoveItem::iMove tt_move = tt.hashMove();
-	int cmp_score = moveScore(move_list[s], ply, depth, tt_move, prev_move), i_score;
+	int cmp_score = moveScore(move_list[s], ply, depth, tt_move, prev_move, prev2_move), i_score;
 
 	for (int i = s + 1; i < move_list.size(); i++) {
-		i_score = moveScore(move_list[i], ply, depth, tt_move, prev_move);
+		i_score = moveScore(move_list[i], ply, depth, tt_move, prev_move, prev2_move);
 
 		if (i_score > cmp_score) {
 			cmp_score = i_score;
@@ -124,22 +219,20 @@ int mOrder::pickBest(
 	return cmp_score;
 }
 
-// pick best tactical move using SEE and promotion ordering
-int mOrder::pickBestTactical(MoveList& capt_list, const int s) {
-	static MoveItem::iMove tmp;
-	int cmp_score = 
-		tacticalScore(capt_list[s]), i_score;
+void mOrder::scoreTactical(const MoveList& capt_list, moveScoresArr& scores, const MoveItem::iMove tt_move) {
+	for (int i = 0; i < capt_list.size(); i++)
+		scores[i] = tacticalScore(capt_list[i], tt_move);
+}
 
-	for (int i = s + 1; i < capt_list.size(); i++) {
-		i_score = tacticalScore(capt_list[i]);
+// pick best tactical move using scores computed once by scoreTactical()
+int mOrder::pickBestTactical(MoveList& capt_list, moveScoresArr& scores, const int s) {
+	int best = s;
 
-		if (i_score > cmp_score) {
-			cmp_score = i_score;
-			tmp = capt_list[i];
-			capt_list[i] = capt_list[s];
-			capt_list[s] = tmp;
-		}
-	}
+	for (int i = s + 1; i < capt_list.size(); i++)
+		if (scores[i] > scores[best]) best = i;
 
-	return cmp_score;
+	std::swap(capt_list[s], capt_list[best]);
+	std::swap(scores[s], scores[best]);
+
+	return scores[s];
 }
@@ -19,7 +19,13 @@ public:
 		EQUAL_CAPTURE_SCORE = FIRST_KILLER_SCORE + 1,
 		RECAPTURE_BONUS = 5,
 
-		RELATIVE_HISTORY_SCALE = 13,
+		COUNTERMOVE_BONUS = 96,
+
+		// history entries are kept within [-MAX_HISTORY, MAX_HISTORY] - 
+		// scales keep quiet scores below killers and capture history bonus within [0, 64]
+		MAX_HISTORY = 16384,
+		QUIET_HISTORY_SCALE = 64,
+		CAPTURE_HISTORY_SCALE = 512,
 	};
 
 	// Most Valuable Victim - Least Valuable Attacker lookup data structure
@@ -32,6 +38,9 @@ public:
 		{ 1000, 2000, 3000, 4000, 5000 }
 	}};
 
+	// scores of moves of a single move list, computed once per node
+	using moveScoresArr = std::array<int, MoveList::MAX_PLAY_MOVES>;
+
 	// Killer Moves lookup table [killer_index][ply_index]
 	using killerLookUp = std::array<std::array<MoveItem::iMove, 128>, 2>;
 	killerLookUp killer;
@@ -40,32 +49,83 @@ public:
 	using historyLookUp = std::array<std::array<int, 64>, 12>;
 	historyLookUp history_moves;
 
-	// Butterfly board of format [piece][to]
-	using butterflyLookUp = std::array<std::array<int, 64>, 12>;
-	butterflyLookUp butterfly;
+	// Capture History lookup table in format [piece][to][captured_piece_type]
+	using captureHistoryLookUp = std::array<std::array<std::array<int, 6>, 64>, 12>;
+	captureHistoryLookUp capture_history;
+
+	// Continuation History lookup tables in format [prev_piece][prev_to][piece][to] -
+	// first one follows opponent's last move (1-ply), second one our own previous move (2-ply)
+	using continuationLookUp = std::array<std::array<historyLookUp, 64>, 12>;
+	std::array<continuationLookUp, 2> continuation;
 
 	// butterfly-based countermove lookup
+	using butterflyLookUp = std::array<std::array<int, 64>, 12>;
 	butterflyLookUp countermove;
 
+	// history tables index of moving piece - [piece][side]
+	static inline int pieceIndex(const MoveItem::iMove move) noexcept {
+		return 2 * move.getPiece() + (move.getSide() != 0);
+	}
+
+	// history update size for given depth
+	static inline int historyBonus(const int depth) noexcept {
+		return std::min(32 * depth * depth, 2048);
+	}
+
+	// gravity-style update - entry saturates at +-MAX_HISTORY, so stale statistics
+	// fade out as new ones come and no overflow nor rescaling is ever needed
+	static inline void gravityUpdate(int& entry, const int bonus) noexcept {
+		entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+	}
+
 	static inline int recaptureBonus(const MoveItem::iMove move, const MoveItem::iMove prev_move) noexcept {
 		return (prev_move.isCapture() and move.getTarget() == prev_move.getTarget()) * RECAPTURE_BONUS;
 	}
 
 	static inline int seeScore(const MoveItem::iMove capt) {
-		return EQUAL_CAPTURE_SCORE + see(capt.getTarget());
+		return EQUAL_CAPTURE_SCORE + see(capt);
 	}
 
 	static inline int promotionScore(const MoveItem::iMove promo_move) noexcept {
 		return PROMOTION_SCORE + promo_move.getPromo();
 	}
 
-	// relative history and countermove heuristic evaluation:
-	// adjust countermove bonus to ply level, since history score of a move 
-	// is increasing as plies are also increasing -
-	// just keep countermove bonus constans relative to history score
-	inline int quietScore(const MoveItem::iMove move, const MoveItem::iMove prev_move, const int target, const int ply) noexcept {
-		const int pc = move.getPiece(), counter_bonus = isCounterMove(move, prev_move) * (ply + 4);
-		return RELATIVE_HISTORY_SCALE * history_moves[pc][target] / (butterfly[pc][target] + 1) + counter_bonus + 1;
+	// sum of main history and both continuation histories of a quiet move
+	inline int quietHistory(
+		const MoveItem::iMove move, const MoveItem::iMove prev_move, const MoveItem::iMove prev2_move
+	) const noexcept {
+		const int pc = pieceIndex(move), to = move.getTarget();
+		return history_moves[pc][to]
+			+ continuation[0][pieceIndex(prev_move)][prev_move.getTarget()][pc][to]
+			+ continuation[1][pieceIndex(prev2_move)][prev2_move.getTarget()][pc][to];
+	}
+
+	// history and countermove heuristic evaluation
+	inline int quietScore(
+		const MoveItem::iMove move, const MoveItem::iMove prev_move, const MoveItem::iMove prev2_move
+	) noexcept {
+		return quietHistory(move, prev_move, prev2_move) / QUIET_HISTORY_SCALE 
+			+ isCounterMove(move, prev_move) * COUNTERMOVE_BONUS;
+	}
+
+	// capture history mapped to [0, 64] bonus, so it only reorders captures of similar value
+	inline int captureHistoryScore(const MoveItem::iMove capt, const int captured) const noexcept {
+		return (capture_history[pieceIndex(capt)][capt.getTarget()][captured] + MAX_HISTORY) / CAPTURE_HISTORY_SCALE;
+	}
+
+	// reward (bonus > 0) or penalize (bonus < 0) quiet move in main and continuation histories
+	inline void updateQuietHistory(
+		const MoveItem::iMove move, const MoveItem::iMove prev_move, const MoveItem::iMove prev2_move, const int bonus
+	) noexcept {
+		const int pc = pieceIndex(move), to = move.getTarget();
+		gravityUpdate(history_moves[pc][to], bonus);
+		gravityUpdate(continuation[0][pieceIndex(prev_move)][prev_move.getTarget()][pc][to], bonus);
+		gravityUpdate(continuation[1][pieceIndex(prev2_move)][prev2_move.getTarget()][pc][to], bonus);
+	}
+
+	// reward or penalize capture - must be called with capture not made on the board
+	inline void updateCaptureHistory(const MoveItem::iMove capt, const int bonus) {
+		gravityUpdate(capture_history[pieceIndex(capt)][capt.getTarget()][capturedType(capt)], bonus);
 	}
 
 	inline bool isCounterMove(const MoveItem::iMove move, const MoveItem::iMove prev_move) {
@@ -73,43 +133,71 @@ public:
 		return countermove[prev_pc][prev_to] == move.raw();
 	}
 
-	// if move is capture return it's SEE score,
-	// else if promotion to queen, return promotion score, currently equal to zero, sane as equal capture score
-	static inline int tacticalScore(const MoveItem::iMove move) {
-		return move.isCapture() ? mOrder::see(move.getTarget()) : 0;
+	// cheap quiescence ordering score - hash move first, then MVV/LVA captures,
+	// promotions and quiet check evasions at the end
+	static inline int tacticalScore(const MoveItem::iMove move, const MoveItem::iMove tt_move) {
+		if (move == tt_move)
+			return HASH_SCORE;
+		else if (move.isCapture())
+			return mvv_lva[move.getPiece()][capturedType(move)] + (move.isPromo() ? promotionScore(move) : 0);
+
+		return move.isPromo() ? promotionScore(move) : 0;
 	}
 
 	// return value, also so called 'score' of a given move
 	int moveScore(
-		const MoveItem::iMove move, const int ply, const int depth, 
-		const MoveItem::iMove tt_move, const MoveItem::iMove prev_move
+		const MoveItem::iMove move, const int ply, const int depth, const MoveItem::iMove tt_move, 
+		const MoveItem::iMove prev_move, const MoveItem::iMove prev2_move
 	);
 
-	// Static Exchange Evaluation for captures
-	static int see(const int sq);
+	// Static Exchange Evaluation of a capture (or promotion) - full swap list value
+	static int see(const MoveItem::iMove capt);
+
+	// check whether Static Exchange Evaluation of a move is greater or equal to threshold -
+	// exchange sequence is stopped as soon as the result is known
+	static bool see_ge(const MoveItem::iMove move, const int threshold);
+
+	// type of piece captured by given move, pawn for en passant
+	static int capturedType(const MoveItem::iMove capt);
 
 	// swap best move so it's on the i'th place
 	int pickBest(
-		MoveList& move_list, const int s, const int ply, 
-		const int depth, const MoveItem::iMove prev_move
+		MoveList& move_list, const int s, const int ply, const int depth, 
+		const MoveItem::iMove prev_move, const MoveItem::iMove prev2_move
 	);
 
-	// pick best capture based on Static Exchange Evaluation
-	int pickBestTactical(MoveList& capt_list, const int s);
+	// score all tactical moves (or check evasions) of the list once
+	static void scoreTactical(const MoveList& capt_list, moveScoresArr& scores, const MoveItem::iMove tt_move);
 
-	// clear butterfly
-	inline void clearButterfly() {
-		for (auto& x : butterfly) x.fill(0);
-	}
+	// swap best scored tactical move so it's on the s'th place
+	static int pickBestTactical(MoveList& capt_list, moveScoresArr& scores, const int s);
 
 	// clear countermove table
 	inline void clearCountermove() {
 		for (auto& x : countermove) x.fill(0);
 	}
 
-	// clear history heuristic table
+	// clear all history heuristic tables
 	inline void clearHistory() {
 		for (auto& x : history_moves) x.fill(0);
+		for (auto& x : capture_history) for (auto& y : x) y.fill(0);
+		for (auto& cont : continuation) for (auto& x : cont) for (auto& y : x) for (auto& z : y) z.fill(0);
+	}
+
+	// exchange all the tables with other instance - used to give every self-play player it's own tables
+	inline void swap(mOrder& other) noexcept {
+		killer.swap(other.killer);
+		history_moves.swap(other.history_moves);
+		capture_history.swap(other.capture_history);
+		continuation.swap(other.continuation);
+		countermove.swap(other.countermove);
+	}
+
+	// age history tables between searches - keep the knowledge, but let it be overwritten quickly
+	inline void ageHistory() {
+		for (auto& x : history_moves) for (auto& v : x) v /= 2;
+		for (auto& x : capture_history) for (auto& y : x) for (auto& v : y) v /= 2;
+		for (auto& cont : continuation) for (auto& x : cont) for (auto& y : x) for (auto& z : y) for (auto& v : z) v /= 2;
 	}
 
 	// clear killer history
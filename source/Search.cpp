@@ -3,6 +3,8 @@
 #include "Evaluation.h"
 #include "Zobrist.h"
 #include "MoveOrder.h"
+#include "Syzygy.h"
+#include <cmath>
 
 
 enum plyNode {
@@ -43,14 +45,17 @@ public:
 			is_root = val;
 		}
 
-		MoveItem::iMove my_prev, node_best_move;
+		MoveItem::iMove my_prev, node_best_move, 
+			// move skipped by singular extension search of the node
+			excluded_move;
 		BitBoardsSet bbs_cpy;
 		gState gstate_cpy;
 		U64 hash_cpy;
-		int score, to, pc, prev_to, prev_pc, m_score;
+		int score, to, pc, prev_to, prev_pc, m_score, static_eval;
 		HashEntry::Flag hash_flag;
-		bool checking_move;
+		bool checking_move, improving;
 		MoveList ml;
+		mOrder::moveScoresArr scores;
 		size_t mcount;
 
 	private:
@@ -69,40 +74,155 @@ private:
 	std::array<NodeDataEntry, max_Ply> node_data;
 } node;
 
-inline int mSearch::dynamicReductionLMR(const int i, const MoveItem::iMove move) {
-	return 1 + (i >= 6 and !move_order.isCounterMove(move, prev_move));
+// excluded-move search keeps its tt entries under separate key -
+// toggle current key between the normal and the excluded-search one around tt access
+inline void toggleExclusionKey(const MoveItem::iMove excluded) {
+	if (excluded != MoveItem::iMove::no_move)
+		hash.key ^= Zobrist::exclusionKey(excluded);
+}
+
+// store search result of the node together with it's static eval
+inline void storeNode(const int ply, const int depth, const int score, const HashEntry::Flag flag, const MoveItem::iMove move) {
+	toggleExclusionKey(node[ply].excluded_move);
+	tt.write(depth, score, flag, ply, move, node[ply].static_eval);
+	toggleExclusionKey(node[ply].excluded_move);
+}
+
+// move made two plies ago - our own previous move
+inline MoveItem::iMove prevMove2(const int ply) {
+	return ply >= 1 ? node[ply - 1].my_prev : MoveItem::iMove::no_move;
+}
+
+namespace {
+	static constexpr int lmr_table_size = 64;
+
+	// late move reductions lookup table in format [depth][move_index]
+	std::array<std::array<int, lmr_table_size>, lmr_table_size> reductions;
+}
+
+void InitState::initReductionsTable() {
+	for (int d = 1; d < lmr_table_size; d++)
+		for (int i = 1; i < lmr_table_size; i++)
+			reductions[d][i] = static_cast<int>(0.75 + std::log(d) * std::log(i) / 2.25);
+}
+
+inline int mSearch::dynamicReductionLMR(
+	const int depth, const int ply, const int i, 
+	const MoveItem::iMove move, const bool is_pv, const bool incheck
+) {
+	int r = reductions[std::min(depth, lmr_table_size - 1)][std::min(i, lmr_table_size - 1)];
+
+	// reduce less in pv nodes, check evasions and checking moves, reduce more if position is not improving
+	r += !node[ply].improving - is_pv - incheck - node[ply].checking_move;
+
+	// quiet moves: reduce less countermoves, reduce more by default and let only
+	// moves with high history score keep (or even decrease) the table reduction
+	if (!move.isCapture()) {
+		const int history = move_order.quietHistory(move, node[ply].my_prev, prevMove2(ply));
+		r -= move_order.isCounterMove(move, node[ply].my_prev);
+		r -= (history - mOrder::MAX_HISTORY) / mOrder::MAX_HISTORY;
+	}
+
+	// always leave at least one ply for the reduced search
+	return std::clamp(r, 0, depth - 2);
 }
 
 // negamax algorithm as an extension of minimax algorithm with alpha-beta pruning framework
 template <bool AllowNullMove>
 int mSearch::alphaBeta(int alpha, int beta, int depth, const int ply) {
 	// (nodes & check_modulo == 0) is an alternative operation to (nodes % check_modulo == 0)
-	if (time_data.is_time and !(nodes & time_check_modulo) and !time_data.checkTimeLeft()) {
+	if (!(nodes & time_check_modulo) and time_data.hardLimitReached(nodes)) {
 		time_data.stop = true;
 		return time_stop_sign;
 	}
 	else if (ply != ROOT and (rep_tt.isRepetition() or game_state.is50moveDraw()))
 		return draw_score;
 
+	// mate distance pruning - even mating at the next move can't beat a shorter mate found already,
+	// and being mated right now can't be worse than alpha
+	if (ply != ROOT) {
+		alpha = std::max(alpha, mate_score + ply);
+		beta = std::min(beta, -(mate_score + ply + 1));
+		if (alpha >= beta) return alpha;
+	}
+
+	// side to move can force a repetition with a single reversible move - 
+	// draw score is then a lower bound of the node score
+	if constexpr (upcoming_rep_detection) {
+		if (ply != ROOT and alpha < draw_score and rep_tt.isUpcomingRepetition(ply)) {
+			alpha = draw_score;
+			if (alpha >= beta) return alpha;
+		}
+	}
+
+	const MoveItem::iMove excluded_move = node[ply].excluded_move;
+	const bool excluded = excluded_move != MoveItem::iMove::no_move;
+
 	// do not use tt in root
 	static int tt_score;
-	if (ply != ROOT and HashEntry::isValid(tt_score = tt.read(alpha, beta, depth, ply)))
-		return tt_score;
-	// break condition and quiescence search
-	else if (depth <= LEAF) {
-		node[ply].score = qSearch(alpha, beta, ply);
+	toggleExclusionKey(excluded_move);
+	tt_score = ply != ROOT ? tt.read(alpha, beta, depth, ply) : HashEntry::no_score;
+	toggleExclusionKey(excluded_move);
 
-		if (!time_data.stop)
-			tt.write(0, node[ply].score,
-				node[ply].score == alpha ? HashEntry::Flag::HASH_ALPHA :
-				node[ply].score == beta ? HashEntry::Flag::HASH_BETA :
-				HashEntry::Flag::HASH_EXACT, ply, MoveItem::iMove::no_move);
-
-		return node[ply].score;
+	if (HashEntry::isValid(tt_score)) {
+		STATS_INC(tt_cutoffs);
+		return tt_score;
+	}
+	// break condition and quiescence search - also when extensions would exceed node resources
+	else if (depth <= LEAF or ply >= max_Ply - 1)
+		return qSearch(alpha, beta, ply);
+
+	// tablebases probe - only right after a zeroing move, tables know nothing about 50 moves rule history
+	if (ply != ROOT and !excluded and game_state.halfmove == 0 and !game_state.castle.raw()) {
+		const int pieces = bitCount(BBs[nOccupied]), cardinality = Syzygy::cardinality();
+
+		if (pieces <= cardinality and (pieces < cardinality or depth >= Syzygy::probe_depth)) {
+			Syzygy::WDLScore wdl;
+
+			if (Syzygy::probeWDL(wdl)) {
+				tb_hits++;
+
+				// cursed wins and blessed losses are draws, scored slightly apart from the real ones
+				const int tb_score = wdl == Syzygy::WDL_WIN ? tb_win - ply
+					: wdl == Syzygy::WDL_LOSS ? -tb_win + ply
+					: draw_score + wdl;
+				const HashEntry::Flag flag = wdl == Syzygy::WDL_WIN ? HashEntry::Flag::HASH_BETA
+					: wdl == Syzygy::WDL_LOSS ? HashEntry::Flag::HASH_ALPHA
+					: HashEntry::Flag::HASH_EXACT;
+
+				if (flag == HashEntry::Flag::HASH_EXACT or (flag == HashEntry::Flag::HASH_BETA and tb_score >= beta)
+					or (flag == HashEntry::Flag::HASH_ALPHA and tb_score <= alpha)) {
+					tt.write(std::min(depth + 6, max_depth - 1), tb_score, flag, ply, MoveItem::iMove::no_move, HashEntry::no_eval);
+					return tb_score;
+				}
+			}
+		}
 	}
 
 	nodes++;
-	const bool incheck = isSquareAttacked(getLS1BIndex(BBs[nWhiteKing + game_state.turn]), game_state.turn);
+	STATS_INC(main_nodes);
+	const bool incheck = isSquareAttacked(getLS1BIndex(BBs[nWhiteKing + game_state.turn]), game_state.turn),
+		is_pv = beta > alpha + 1;
+
+	// static evaluation computed once per node, or taken from tt if cached there -
+	// position is improving, if it's static eval is better than the one from our previous move
+	if (incheck)
+		node[ply].static_eval = HashEntry::no_eval;
+	else if ((node[ply].static_eval = tt.staticEval()) == HashEntry::no_eval)
+		node[ply].static_eval = Eval::evaluate(low_bound, high_bound);
+
+	node[ply].improving = ply < 2 or node[ply - 2].static_eval == HashEntry::no_eval
+		or node[ply].static_eval > node[ply - 2].static_eval;
+
+	node[ply].initNodeData(prev_move);
+
+	// Reverse Futility Pruning (static null move pruning) - 
+	// static eval is so far above beta, that even losing a margin per depth left won't change a fail-high
+	if (!is_pv and !incheck and !excluded and depth <= rfp_depth and beta > mate_comp and beta < -mate_comp
+		and node[ply].static_eval - rfp_margin * (depth - node[ply].improving) >= beta) {
+		STATS_INC(reverse_futility_prunes);
+		return beta;
+	}
 
 	// Null Move Pruning 
 	if constexpr (AllowNullMove) {
@@ -114,42 +234,140 @@ int mSearch::alphaBeta(int alpha, int beta, int depth, const int ply) {
 
 			rep_tt.posRegister();
 			MovePerform::makeNull();
+			prev_move = MoveItem::iMove::no_move;
 
 			// set allow_null_move to false - prevent from double move passing, it makes no sense then
 			node[ply].score = -alphaBeta<false>(-beta, -beta + 1, depth - 1 - R, ply + 1);
 
 			MovePerform::unmakeNull(node[ply].hash_cpy, ep_cpy);
 			rep_tt.count--;
+			prev_move = node[ply].my_prev;
 
-			if (node[ply].score >= beta) return beta;
+			if (node[ply].score >= beta) {
+				STATS_INC(null_prunes);
+				return beta;
+			}
+		}
+	}
+
+	// ProbCut - if a good capture beats beta raised by a margin in a reduced search, 
+	// the full-depth search would most likely fail high as well
+	if (!is_pv and !incheck and !excluded and depth >= probcut_depth and beta > mate_comp and beta < -mate_comp) {
+		const int probcut_beta = beta + probcut_margin,
+			probcut_depth_left = depth - probcut_reduction;
+
+		// tt entry deep enough may already predict result of probcut search
+		const int tt_bound = tt.read(probcut_beta - 1, probcut_beta, probcut_depth_left, ply);
+
+		if (HashEntry::isValid(tt_bound)) {
+			if (tt_bound >= probcut_beta) {
+				STATS_INC(probcut_prunes);
+				return beta;
+			}
+		}
+		else {
+			MoveGenerator::generateLegalMoves<MoveGenerator::CAPTURES>(node[ply].ml);
+
+			for (const auto& move : node[ply].ml) {
+				// capture has no chance to lift static eval above raised beta
+				if (!mOrder::see_ge(move, probcut_beta - node[ply].static_eval))
+					continue;
+
+				STATS_INC(probcut_searches);
+				rep_tt.posRegister();
+				MovePerform::makeMove(move);
+				prev_move = move;
+
+				// cheap quiescence verification first, then the reduced search
+				node[ply].score = -qSearch(-probcut_beta, -probcut_beta + 1, ply + 1);
+
+				if (node[ply].score >= probcut_beta)
+					node[ply].score = -alphaBeta(-probcut_beta, -probcut_beta + 1, probcut_depth_left, ply + 1);
+
+				MovePerform::unmakeMove(node[ply].bbs_cpy, node[ply].gstate_cpy);
+				rep_tt.count--;
+				hash.key = node[ply].hash_cpy;
+				prev_move = node[ply].my_prev;
+
+				if (time_data.stop)
+					return time_stop_sign;
+				else if (node[ply].score >= probcut_beta) {
+					STATS_INC(probcut_prunes);
+					tt.write(probcut_depth_left + 1, probcut_beta, HashEntry::Flag::HASH_BETA, ply, move, node[ply].static_eval);
+					return beta;
+				}
+			}
+		}
+	}
+
+	// Internal Iterative Reduction - node without hash move is searched the first time or it's entry
+	// has been overwritten, so move ordering is poor - reduce it, next iteration will have a hash move then
+	if (ply != ROOT and !excluded and depth >= iir_depth and tt.hashMove() == MoveItem::iMove::no_move) {
+		STATS_INC(iir_reductions);
+		depth--;
+	}
+
+	// Singular Extension - hash move is singular, if all the other moves fail low against a bound
+	// lowered below it's tt score in a reduced search excluding it - extend such a move then
+	const MoveItem::iMove tt_move = tt.hashMove();
+	bool singular_ext = false;
+
+	if (ply != ROOT and !excluded and depth >= se_depth and tt_move != MoveItem::iMove::no_move) {
+		const HashEntry* entry = tt.probe();
+
+		if (entry and entry->depth >= depth - 3 and entry->flag != HashEntry::Flag::HASH_ALPHA
+			and entry->score > mate_comp and entry->score < -mate_comp) {
+			const int singular_beta = entry->score - se_margin * depth;
+
+			STATS_INC(singular_searches);
+			node[ply].excluded_move = tt_move;
+			node[ply].score = alphaBeta<false>(singular_beta - 1, singular_beta, (depth - 1) / 2, ply);
+			node[ply].excluded_move = MoveItem::iMove::no_move;
+
+			if (time_data.stop)
+				return time_stop_sign;
+
+			// excluded-move search used the same node resources
+			node[ply].initNodeData(prev_move);
+
+			if (node[ply].score < singular_beta) {
+				STATS_INC(singular_extensions);
+				singular_ext = true;
+			}
+			// multi-cut - hash move is not the only one beating beta, so node will most likely fail high
+			else if (singular_beta >= beta) {
+				STATS_INC(multi_cuts);
+				return beta;
+			}
 		}
 	}
 
 	// use fully-legal moves generator
 	MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(node[ply].ml);
+
+	// search only root moves preserving tablebase result
+	if (ply == ROOT and tb_root_moves.size())
+		node[ply].ml = tb_root_moves;
+
 	node[ply].mcount = node[ply].ml.size();
 
 	// no legal moves detected - checkmate or stealmate
 	if (!node[ply].mcount)
 		return incheck ? mate_score + ply : draw_score;
 	// check extension
-	else if (incheck) {
+	else if (incheck)
 		depth++;
 
-		// single-response extra time
-		if (node[ply].mcount == 1 and time_data.is_time and time_data.this_move > 300_ms
-			and time_data.this_move < time_data.left / 10)
-			time_data.this_move += 185_ms;
-	}
-
-	node[ply].initNodeData(prev_move);
 	bool is_pruned = false;
 
 	for (int fail_low_count = 0, i = 0; i < node[ply].mcount; i++, is_pruned = false) {
 		// move ordering
-		node[ply].m_score = move_order.pickBest(node[ply].ml, i, ply, depth, prev_move);
+		node[ply].m_score = move_order.pickBest(node[ply].ml, i, ply, depth, prev_move, prevMove2(ply));
 		const auto& move = node[ply].ml[i];
 
+		if (move == excluded_move)
+			continue;
+
 		// futility pruning and razoring routine
 		if (i >= 1 and ply != ROOT and node[ply].mcount >= 8 and !incheck and move.getPromo() != QUEEN
 			and (!move.isCapture() or node[ply].m_score < mOrder::FIRST_KILLER_SCORE)
@@ -159,23 +377,20 @@ int mSearch::alphaBeta(int alpha, int beta, int depth, const int ply) {
 			static constexpr int futility_margin = 80, ext_margin = 450, razor_margin = 950;
 
 			// pure futility pruning at frontiers
-			if (depth == FRONTIER
-				and Eval::evaluate(alpha - futility_margin, alpha - futility_margin + 1) <= alpha - futility_margin)
+			if (depth == FRONTIER and node[ply].static_eval <= alpha - futility_margin) {
+				STATS_INC(futility_prunes);
 				return alpha;
+			}
 			// extended futility pruning at pre-frontiers
-			else if (depth == PRE_FRONTIER
-				and Eval::evaluate(alpha - ext_margin, alpha - ext_margin + 1) <= alpha - ext_margin)
+			else if (depth == PRE_FRONTIER and node[ply].static_eval <= alpha - ext_margin) {
+				STATS_INC(futility_prunes);
 				return alpha;
+			}
 			// razoring reduction at pre-pre-frontiers
-			else if (depth == PRE_PRE_FRONTIER
-				and Eval::evaluate(alpha - razor_margin, alpha - razor_margin + 1) <= alpha - razor_margin)
+			else if (depth == PRE_PRE_FRONTIER and node[ply].static_eval <= alpha - razor_margin) {
+				STATS_INC(razor_reductions);
 				depth = PRE_FRONTIER;
-		} 
-		// recapture extra time - although it looks strange, it makes engine a little bit stronger
-		else if (node[ply].prev_to == (move.getTarget())
-			and time_data.is_time and time_data.this_move > 300_ms
-			and time_data.this_move < time_data.left / 12) {
-			time_data.this_move += 50_ms;
+			}
 		}
 
 		rep_tt.posRegister();
@@ -187,23 +402,31 @@ int mSearch::alphaBeta(int alpha, int beta, int depth, const int ply) {
 		// based on an assumption that probability of finding a good move after processing many good moves before
 		// decreases significantly.
 		if (fail_low_count > 8 and node[ply].mcount >= 10 and depth >= 4 and !node[ply].checking_move
-			and (!move.isCapture() or node[ply].m_score < mOrder::FIRST_KILLER_SCORE) and move.getPromo() != QUEEN)
+			and (!move.isCapture() or node[ply].m_score < mOrder::FIRST_KILLER_SCORE) and move.getPromo() != QUEEN) {
+			STATS_INC(lmp_prunes);
 			is_pruned = true;
+		}
 		else {
+			STATS_INC(searched_moves);
+
 			// if PV move (hash move) is already processed, save time by checking uninteresting moves 
 			// using null window and late move reduction (PV Search) -
 			// however, if such 'late' node fails low, it's a sign we are offered a good move (score > alpha)
-			if (node[ply].m_score < mOrder::HASH_SCORE and depth >= 3 and !node[ply].checking_move and !incheck
+			if (node[ply].m_score < mOrder::HASH_SCORE and depth >= 3 and i >= 1
 				and (!move.isCapture() or node[ply].m_score < mOrder::FIRST_KILLER_SCORE)
 				and move.getPromo() != QUEEN) {
 				// late move reduction in null move search
-				const int depth_reduction = dynamicReductionLMR(i, move);
+				const int depth_reduction = dynamicReductionLMR(depth, ply, i, move, is_pv, incheck);
 				node[ply].score = -alphaBeta(-alpha - 1, -alpha, depth - 1 - depth_reduction, ply + 1);
+				STATS_INC(lmr_searches);
+
+				if (node[ply].score > alpha)
+					STATS_INC(lmr_researches);
 			}
 			else node[ply].score = alpha + 1;
 
 			if (node[ply].score > alpha) {
-				node[ply].score = -alphaBeta(-beta, -alpha, depth - 1, ply + 1);
+				node[ply].score = -alphaBeta(-beta, -alpha, depth - 1 + (singular_ext and move == tt_move), ply + 1);
 				fail_low_count++;
 			}
 		}
@@ -214,35 +437,52 @@ int mSearch::alphaBeta(int alpha, int beta, int depth, const int ply) {
 		prev_move = node[ply].my_prev;
 
 		if (time_data.stop) {
-			tt.write(depth, alpha, node[ply].hash_flag, ply, node[ply].node_best_move);
+			storeNode(ply, depth, alpha, node[ply].hash_flag, node[ply].node_best_move);
 			return time_stop_sign;
 		}
 		else if (is_pruned)
 			break;
 
-		// register move appearance in butterfly board
 		node[ply].to = move.getTarget();
 		node[ply].pc = move.getPiece();
-		move_order.butterfly[node[ply].pc][node[ply].to] += depth;
 
 		if (node[ply].score > alpha) {
 			node[ply].node_best_move = move;
 
 			// fail hard beta-cutoff
 			if (node[ply].score >= beta) {
+				STATS_INC(fail_high);
+				if (i == 0) STATS_INC(fail_high_first);
+
+				const int bonus = mOrder::historyBonus(depth);
+
 				if (!move.isCapture()) {
 					// store killer move
 					move_order.killer[1][ply] = move_order.killer[0][ply];
 					move_order.killer[0][ply] = move;
 
-					// store move as a history move
-					move_order.history_moves[node[ply].pc][node[ply].to] += depth * depth;
+					// reward move in history and continuation histories
+					move_order.updateQuietHistory(move, node[ply].my_prev, prevMove2(ply), bonus);
 
 					// store a countermove
 					move_order.countermove[node[ply].prev_pc][node[ply].prev_to] = move.raw();
 				}
+				else move_order.updateCaptureHistory(move, bonus);
+
+				// penalize moves searched before the cutoff one - 
+				// captures always, quiets only if they lost against a quiet move
+				for (int j = 0; j < i; j++) {
+					const auto& tried = node[ply].ml[j];
+
+					if (tried == excluded_move)
+						continue;
+					else if (tried.isCapture())
+						move_order.updateCaptureHistory(tried, -bonus);
+					else if (!move.isCapture())
+						move_order.updateQuietHistory(tried, node[ply].my_prev, prevMove2(ply), -bonus);
+				}
 
-				tt.write(depth, beta, HashEntry::Flag::HASH_BETA, ply, move);
+				storeNode(ply, depth, beta, HashEntry::Flag::HASH_BETA, move);
 				return beta;
 			}
 
@@ -251,7 +491,7 @@ int mSearch::alphaBeta(int alpha, int beta, int depth, const int ply) {
 		}
 	}
 
-	tt.write(depth, alpha, node[ply].hash_flag, ply, node[ply].node_best_move);
+	storeNode(ply, depth, alpha, node[ply].hash_flag, node[ply].node_best_move);
 	// fail-low cutoff (return best option)
 	return alpha;
 }
@@ -260,73 +500,144 @@ template int mSearch::alphaBeta<false>(int alpha, int beta, int depth, const int
 template int mSearch::alphaBeta<true>(int alpha, int beta, int depth, const int ply);
 
 // quiescence search - protect from dangerous consequences of horizon effect
-int mSearch::qSearch(int alpha, int beta, const int ply) {
-	if (time_data.is_time and !(nodes & time_check_modulo) and !time_data.checkTimeLeft()) {
+int mSearch::qSearch(int alpha, int beta, const int ply, const int depth) {
+	if (!(nodes & time_check_modulo) and time_data.hardLimitReached(nodes)) {
 		time_data.stop = true;
 		return time_stop_sign;
 	} 
 
-	const int eval = Eval::evaluate(alpha - Eval::Value::QUEEN_VALUE, beta);
 	nodes++;
+	STATS_INC(qnodes);
 
-	if (eval >= beta) 
-		return beta;
+	// mate distance pruning
+	alpha = std::max(alpha, mate_score + ply);
+	beta = std::min(beta, -(mate_score + ply + 1));
+	if (alpha >= beta)
+		return alpha;
+
+	// quiescence entries are stored with zero depth, so any entry is deep enough
+	static int tt_score;
+	if (HashEntry::isValid(tt_score = tt.read(alpha, beta, 0, ply))) {
+		STATS_INC(tt_cutoffs);
+		return tt_score;
+	}
 
 	const bool incheck = isSquareAttacked(getLS1BIndex(BBs[nWhiteKing + game_state.turn]), game_state.turn),
 		is_endgame = game_state.gamePhase() == gState::ENDGAME;
+	const int old_alpha = alpha;
 
-	// delta pruning
-	if (!is_endgame and !incheck and eval + Eval::Value::QUEEN_VALUE <= alpha)
-		return alpha;
-	alpha = std::max(alpha, eval);
+	// stand pat on cached static eval - side in check has no stand pat option and has to evade
+	if (incheck) {
+		node[ply].static_eval = HashEntry::no_eval;
+
+		// no node resources left to search evasions
+		if (ply >= max_Ply - 1)
+			return draw_score;
+	}
+	else {
+		if ((node[ply].static_eval = tt.staticEval()) == HashEntry::no_eval)
+			node[ply].static_eval = Eval::evaluate(low_bound, high_bound);
+
+		// maximum ply reached - static eval is not a bound of the node score, so nothing is stored
+		if (ply >= max_Ply - 1)
+			return node[ply].static_eval;
+		else if (node[ply].static_eval >= beta) {
+			tt.write(0, beta, HashEntry::Flag::HASH_BETA, ply, MoveItem::iMove::no_move, node[ply].static_eval);
+			return beta;
+		}
+		// delta pruning
+		else if (!is_endgame and node[ply].static_eval + Eval::Value::QUEEN_VALUE <= alpha)
+			return alpha;
+
+		alpha = std::max(alpha, node[ply].static_eval);
+	}
+
+	// full evasions in check, captures and promotions otherwise
+	if (incheck) {
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(node[ply].ml);
+
+		if (!node[ply].ml.size())
+			return mate_score + ply;
+	}
+	else MoveGenerator::generateLegalMoves<MoveGenerator::TACTICAL>(node[ply].ml);
 
-	MoveGenerator::generateLegalMoves<MoveGenerator::TACTICAL>(node[ply].ml);
 	node[ply].bbs_cpy = BBs;
 	node[ply].gstate_cpy = game_state;
 	node[ply].hash_cpy = hash.key;
+	node[ply].node_best_move = MoveItem::iMove::no_move;
 
 	// losing material indication flag
 	const bool minus_matdelta = (game_state.material[game_state.turn] - game_state.material[!game_state.turn]) < 0;
 
-	for (int i = 0; i < node[ply].ml.size(); i++) {
-		// capture ordering
-		node[ply].m_score = move_order.pickBestTactical(node[ply].ml, i);
-		const auto& move = node[ply].ml[i];
+	// tactical moves (or evasions) first, then quiet checks on the first quiescence ply
+	bool quiet_checks = false;
 
-		if (!is_endgame and !incheck and !move.isPromo()) {
-			// equal captures pruning margin
-			static constexpr int equal_margin = 120;
+	while (true) {
+		mOrder::scoreTactical(node[ply].ml, node[ply].scores, tt.hashMove());
 
-			// bad captures pruning
-			if (node[ply].m_score <= -200)
-				return alpha;
-			// equal captures pruning if losing material
-			else if (minus_matdelta and !node[ply].m_score and eval + equal_margin <= alpha)
-				return alpha;
-		}
+		for (int i = 0; i < node[ply].ml.size(); i++) {
+			// capture ordering
+			node[ply].m_score = mOrder::pickBestTactical(node[ply].ml, node[ply].scores, i);
+			const auto& move = node[ply].ml[i];
 
-		MovePerform::makeMove(move);
+			if (quiet_checks) {
+				// checks hanging the moved piece
+				if (!mOrder::see_ge(move, 0))
+					continue;
 
-		node[ply].score = -qSearch(-beta, -alpha, ply + 1);
+				STATS_INC(qcheck_searches);
+			}
+			else if (!is_endgame and !incheck and !move.isPromo()) {
+				// bad captures pruning threshold and equal captures pruning margin
+				static constexpr int bad_capture = -199, equal_margin = 120;
+
+				// bad captures pruning
+				if (!mOrder::see_ge(move, bad_capture))
+					continue;
+				// equal captures pruning if losing material
+				else if (minus_matdelta and node[ply].static_eval + equal_margin <= alpha and !mOrder::see_ge(move, 1))
+					continue;
+			}
 
-		MovePerform::unmakeMove(node[ply].bbs_cpy, node[ply].gstate_cpy);
-		hash.key = node[ply].hash_cpy;
+			MovePerform::makeMove(move);
 
-		if (time_data.stop)
-			return time_stop_sign;
-		else if (node[ply].score > alpha) {
-			if (node[ply].score >= beta) return beta;
-			alpha = node[ply].score;
+			node[ply].score = -qSearch(-beta, -alpha, ply + 1, depth - 1);
+
+			MovePerform::unmakeMove(node[ply].bbs_cpy, node[ply].gstate_cpy);
+			hash.key = node[ply].hash_cpy;
+
+			if (time_data.stop)
+				return time_stop_sign;
+			else if (node[ply].score > alpha) {
+				if (node[ply].score >= beta) {
+					tt.write(0, beta, HashEntry::Flag::HASH_BETA, ply, move, node[ply].static_eval);
+					return beta;
+				}
+
+				alpha = node[ply].score;
+				node[ply].node_best_move = move;
+			}
 		}
+
+		// quiet checks only on the first quiescence ply and only when static eval
+		// is close enough to alpha, so that the check could matter
+		if (quiet_checks or incheck or depth < 0 or node[ply].static_eval + qcheck_margin <= old_alpha)
+			break;
+
+		MoveGenerator::generateLegalMoves<MoveGenerator::QUIET_CHECKS>(node[ply].ml);
+		quiet_checks = true;
 	}
 
+	tt.write(0, alpha, alpha > old_alpha ? HashEntry::Flag::HASH_EXACT : HashEntry::Flag::HASH_ALPHA,
+		ply, node[ply].node_best_move, node[ply].static_eval);
+
 	return alpha;
 }
 
 inline void mSearch::clearSearchHistory() {
-	nodes = 0;
-	move_order.clearButterfly();
-	move_order.clearHistory();
+	nodes = tb_hits = 0;
+	stats.clear();
+	move_order.ageHistory();
 	move_order.clearKiller();
 }
 
@@ -339,12 +650,23 @@ void mSearch::bestMove(int depth) {
 	tt.increaseAge();
 		
 	int lbound = low_bound, hbound = high_bound,
-		curr_dpt = 1, score, prev_score;
+		curr_dpt = 1, score, prev_score = draw_score;
 	long long time = 0;
-	MoveItem::iMove ponder;
+	MoveItem::iMove ponder, prev_best = MoveItem::iMove::no_move;
 
 	time_data.start = now();
 
+	// filter root moves with DTZ tables - search then decides between moves of the same rank
+	tb_root_moves = MoveList();
+
+	if (!game_state.castle.raw() and bitCount(BBs[nOccupied]) <= Syzygy::cardinality()) {
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(tb_root_moves);
+
+		if (Syzygy::rootProbe(tb_root_moves))
+			tb_hits += tb_root_moves.size();
+		else tb_root_moves = MoveList();
+	}
+
 	// aspiration window reduction size
 	constexpr int asp_margin = static_cast<int>(0.45 * Eval::Value::PAWN_VALUE);
 
@@ -374,19 +696,32 @@ void mSearch::bestMove(int depth) {
 		// no checkmate
 		else OS << "info score cp " << score;
 
+		time = sinceStart_ms(time_data.start);
+
 		OS  << " depth " << curr_dpt
 			<< " nodes " << nodes
-			<< " time " << (time = sinceStart_ms(time_data.start))
+			<< " time " << time
 			<< " nps " << static_cast<int>(nodes / (1. * (time + 1) / 1000))
+			<< " tbhits " << tb_hits
 			<< " pv ";
 
 		tt.recreatePV(curr_dpt++, node[ROOT].node_best_move, ponder);
 
-		if (time_data.stop 
-			or (time_data.is_time and 5 * sinceStart_ms(time_data.start) / 2 > time_data.this_move))
+		if (stats_info)
+			OS << "info string " << stats.summary() << '\n';
+
+		// update soft time limit using stability of the search results
+		if (curr_dpt > 2)
+			time_data.updateStability(node[ROOT].node_best_move != prev_best, prev_score - score);
+
+		if (time_data.stop or time_data.softLimitReached())
+			break;
+		// proven mate not longer than searched depth - deeper iterations won't find a shorter one
+		else if (score > -mate_comp and -score - mate_score <= curr_dpt - 1)
 			break;
 
 		prev_score = score;
+		prev_best = node[ROOT].node_best_move;
 	}
 
 	OS << "bestmove ";
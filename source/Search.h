@@ -3,6 +3,7 @@
 #include "MoveItem.h"
 #include "Timer.h"
 #include "MoveOrder.h"
+#include "SearchStats.h"
 #include <limits>
 
 // main search class.
@@ -24,30 +25,91 @@ public:
 		max_Ply = 128,
 		time_check_modulo = 2048,
 
-		time_stop_sign = low_bound + 10;
+		time_stop_sign = low_bound + 10,
+
+		// reverse futility pruning depth limit and margin per depth
+		rfp_depth = 6,
+		rfp_margin = 90,
+
+		// minimal depth of internal iterative reduction
+		iir_depth = 4,
+
+		// probcut minimal depth, raised beta margin and depth reduction of probcut search
+		probcut_depth = 3,
+		probcut_margin = 100,
+		probcut_reduction = 2,
+
+		// singular extension minimal depth and singular beta margin per depth
+		se_depth = 8,
+		se_margin = 2,
+
+		// quiet checks in quiescence are skipped when static eval is below alpha by this margin
+		qcheck_margin = 100,
+
+		// tablebase win score - below the checkmate range, decreased by ply of the probed node
+		tb_win = -mate_comp - 1 - max_Ply;
+
+	// claim draws one ply earlier using cuckoo tables of reversible moves
+	static constexpr bool upcoming_rep_detection = true;
+
+	// clamp score to checkmate range and make mate scores relative to the node, before storing it in tt
+	static constexpr int mateToTT(int score, const int ply) noexcept {
+		score = std::clamp(score, mate_score, -mate_score);
+		return score < mate_comp ? score - ply : score > -mate_comp ? score + ply : score;
+	}
+
+	// make mate score read from tt relative to the root again
+	static constexpr int mateFromTT(const int score, const int ply) noexcept {
+		return score < mate_comp ? score + ply : score > -mate_comp ? score - ply : score;
+	}
 
 	// calculate best move using Iterative Deepening
 	void bestMove(const int depth);
 
+	// number of nodes visited during last search
+	inline ULL searchedNodes() const noexcept { return nodes; }
+
+	// number of successful tablebase probes during last search
+	inline ULL tablebaseHits() const noexcept { return tb_hits; }
+
 	Time time_data;
 	mOrder move_order;
 	MoveItem::iMove prev_move;
 
+	// statistics of the last search, filled only with __SEARCH_STATS__ defined
+	SearchStats stats;
+	// append statistics to 'info string' after each iteration
+	bool stats_info = false;
+
 private:
 	class NodesResources;
 
-	inline int dynamicReductionLMR(const int i, const MoveItem::iMove move);
+	// reduction of late move taken from log-log lookup table and adjusted to node/move properties
+	inline int dynamicReductionLMR(
+		const int depth, const int ply, const int i, 
+		const MoveItem::iMove move, const bool is_pv, const bool incheck
+	);
 	void clearSearchHistory();
 
 	// generate game tree, fill node resources and return positional score
 	template <bool AllowNullMove = true>
 	int alphaBeta(int alpha, int beta, int depth, const int ply);
 
-	int qSearch(int alpha, int beta, const int ply);
+	// quiescence search - depth 0 is the first quiescence ply, where quiet checks are also searched
+	int qSearch(int alpha, int beta, const int ply, const int depth = 0);
 
-	ULL nodes;
+	ULL nodes, tb_hits;
+
+	// root moves preserving the best tablebase result, empty if root position wasn't probed
+	MoveList tb_root_moves;
 
 }; // class mSearch
 
 
-extern mSearch m_search;
\ No newline at end of file
+extern mSearch m_search;
+
+
+namespace InitState {
+	// fill late move reductions lookup table
+	void initReductionsTable();
+}
\ No newline at end of file
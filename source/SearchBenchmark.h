@@ -1,27 +1,163 @@
 #pragma once
 
 #include "Timer.h"
-#include "SearchBenchmark.h"
 #include "UCI.h"
+#include "Search.h"
+#include "Zobrist.h"
 #include <iostream>
+#include <iomanip>
 #include <string>
 #include <fstream>
+#include <array>
 
 
 // simple benchmark driver
 class SearchBenchmark {
 public:
 	SearchBenchmark() = default;
-	inline void start();
+
+	static constexpr int
+		default_depth = 8,
+		default_hash_MB = 16,
+		default_threads = 1;
+
+	// built-in bench - search every embedded position at fixed depth,
+	// print nodes and time of each position, total node signature and nps
+	inline ULL run(int depth = default_depth, int hash_MB = default_hash_MB, int threads = default_threads);
+
+	// parse optional '[depth] [hashMB] [threads]' arguments and run built-in bench
+	inline ULL run(std::istream& args);
+
+	// execute commands located in .txt file and measure time
+	inline void start(const std::string& path = script_path);
+
+	static constexpr const char* script_path = "source/BenchmarkScript.txt";
+
+	// positions of built-in bench
+	static constexpr std::array<const char*, 35> positions = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPP2PPP/RNBQKBNR w KQkq - 0 4",
+		"r2qkb1r/ppp2ppp/2n5/3Pp3/3n4/8/PPP2PPP/RN1QKB1R w KQkq - 0 11",
+		"rnbqkb1r/pp2pppp/2p2n2/2P5/4P3/2N5/PPP2PPP/R1BQKBNR b KQkq - 0 6",
+		"r3k2r/ppppqppp/2n2n2/2b1p3/2B1P3/2N2N2/PPP1QPPP/R3K2R w KQkq - 0 10",
+		"4r3/pppk1ppp/8/3p4/3P4/8/PPP2PPP/4K2R w K - 0 16",
+		"r2qr1k1/pppb1ppp/2p1p3/4N3/2B1n3/8/PPP2PPP/2KRR3 w - - 0 17",
+		"r2qk2r/ppp1bppp/2p5/2b1P3/8/2P5/PP2BPPP/R2QK2R b KQkq - 0 10",
+		"8/4k3/8/4p3/4P3/8/8/4K3 w - - 0 42",
+		"r2qkb1r/pppb1ppp/2n5/3p4/3P4/2N2N2/PPPQBPPP/2KR3R b kq - 0 11",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"rnbqkb1r/pp1p1pPp/8/2p1pP2/1P1P4/3P3P/P1P1P3/RNBQKBNR w KQkq e6 0 1",
+		"r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9",
+		"3Bnk2/2p2P2/b1r1P3/2p2p2/3p1n2/P6p/8/3Q3K b - - 0 1",
+		"8/8/R2pp1b1/4pp2/1nr4P/1B3kP1/4RN2/2BK4 w - - 0 1",
+		"3r4/3p2p1/4pP1q/1p1bn1kP/5p2/1N6/7K/4b2n w - - 0 1",
+		"6K1/1pqP4/Q3pp2/R3P3/3PB2P/8/p2k3p/R7 b - - 0 1",
+		"8/PP1p2R1/5q2/2P4r/1P3p2/1P6/B1P3Kp/k2b4 b - - 0 1",
+		"8/p1P1N3/3p3p/1r4P1/2PBP3/Kp4k1/p3Q3/5B2 w - - 0 1",
+		"2R1b2r/3p4/4k1qN/P5n1/3KP2n/3P2b1/1P2p3/8 b - - 0 1",
+		"4N3/k1pP2n1/3P4/3b1rQ1/4n1B1/2p1KP2/1p6/1N6 w - - 0 1",
+		"8/2kr1P2/n7/2pP2n1/Pq3rB1/p2K4/N7/B2N4 b - - 0 1",
+		"3b4/3PP3/b3P3/2Q5/K3p3/3p3P/1Rp2P2/5BNk b - - 0 1",
+		"2r2B2/2P4P/8/1pp2R1b/2B4P/7K/N2p2P1/3N3k b - - 0 1",
+		"8/2PRN3/1n1p4/p1Q5/p2P3r/3p4/Pk3P1b/5K2 b - - 0 1",
+		"1K6/4P1P1/N1p5/2rp1p2/4Q1q1/5nrp/1k1b4/5n2 w - - 0 1",
+		"8/4p3/KB5P/2Pp1Q1q/4B1PP/2prn3/k7/6N1 w - - 0 1",
+		"1N1B4/8/1K2R1q1/P2k2P1/4pp1p/P5b1/2p5/3n1R2 b - - 0 1",
+		"k1b5/P4K2/8/P3B1q1/3pP3/1Q1P1P2/1P1p1p1p/8 w - - 0 1",
+		"5B2/6P1/1p6/8/1N6/kP6/2K5/8 b - - 0 1",
+		"rnbqkbnr/pppp1ppp/4p3/8/3PP3/8/PPP2PPP/RNBQKBNR w KQkq - 0 4",
+		"rnbqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPP1QPPP/RNB1K2R b KQkq - 0 5",
+		"rnbqkb1r/ppp2ppp/4pn2/3p4/3PP3/2N2N2/PPP2PPP/R1BQKB1R w KQkq - 0 6",
+		"rnbqkb1r/ppp1pppp/2p2n2/3p4/2B1P3/5N2/PPP2PPP/RNBQK2R w KQkq - 0 5",
+		"rnbqkb1r/ppp2ppp/8/3pp3/3BP3/5N2/PPP2PPP/RNBQK1NR b KQkq - 0 6",
+	};
+
 private:
 	std::ifstream src;
 };
 
+
+inline ULL SearchBenchmark::run(int depth, int hash_MB, int threads) {
+	static Timer timer;
+
+	std::ostream* const out = OS_PTR;
+	std::ostream null_stream(nullptr);
+	const size_t prev_hash_MB = tt.sizeMB();
+	ULL total_nodes = 0, nodes;
+	long long total_time = 0, time;
+
+	tt.setSize(hash_MB);
+
+	// search is single-threaded, threads argument is accepted for standard bench interface only
+	*out << "bench depth " << depth << " hash " << tt.sizeMB() << " threads 1"
+		<< (threads != 1 ? " (multi-threaded search not supported)" : "") << '\n';
+
+	// silence search output
+	OS_PTR = &null_stream;
+
+	for (size_t i = 0; i < positions.size(); i++) {
+		tt.clear();
+		rep_tt.clear();
+		m_search.move_order.clearCountermove();
+		m_search.move_order.clearHistory();
+		m_search.prev_move = MoveItem::iMove::no_move;
+		m_search.time_data.setFixedTime(0);
+		BBs.parseFEN(positions[i]);
+
+		timer.go();
+		m_search.bestMove(depth);
+		timer.stop();
+
+		nodes = m_search.searchedNodes();
+		time = timer.duration();
+		total_nodes += nodes;
+		total_time += time;
+
+		*out << "Position " << std::setw(2) << i + 1 << '/' << positions.size()
+			<< ": nodes " << std::setw(10) << nodes
+			<< " time " << std::setw(6) << time << " ms\n";
+	}
+
+	OS_PTR = out;
+
+	OS << "===========================\n"
+		<< "Total time (ms) : " << total_time << '\n'
+		<< "Nodes searched  : " << total_nodes << '\n'
+		<< "Nodes/second    : " << static_cast<ULL>(total_nodes / (1. * (total_time + 1) / 1000)) << '\n';
+
+	// restore engine state
+	tt.setSize(prev_hash_MB);
+	rep_tt.clear();
+	BBs.parseFEN(BitBoardsSet::start_pos);
+
+	return total_nodes;
+}
+
+inline ULL SearchBenchmark::run(std::istream& args) {
+	int depth = default_depth, hash_MB = default_hash_MB, threads = default_threads, val;
+
+	// every argument is optional, but they have to keep their order
+	if (args >> val) {
+		depth = val;
+		if (args >> val) {
+			hash_MB = val;
+			if (args >> val) threads = val;
+		}
+	}
+
+	return run(std::max(depth, 1), hash_MB, threads);
+}
+
 // execute commands located in .txt file and measure time
-inline void SearchBenchmark::start() {
+inline void SearchBenchmark::start(const std::string& path) {
 	static Timer timer;
 
-	src.open("source\\BenchmarkScript.txt");
+	src.open(path);
+
+	if (!src.is_open()) {
+		OS << "benchmark script '" << path << "' not found\n";
+		return;
+	}
 
 	// change current input stream to given file
 	IS_PTR = &src;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "BitBoard.h"
+#include <string>
+#include <sstream>
+#include <iomanip>
+
+// search statistics are collected only when compiled with __SEARCH_STATS__ defined -
+// otherwise all the counter updates expand to nothing, so there is no overhead in search
+#if defined(__SEARCH_STATS__)
+#define STATS_INC(counter) (m_search.stats.counter++)
+#else
+#define STATS_INC(counter) ((void)0)
+#endif
+
+
+// counters describing shape of the last search tree
+struct SearchStats {
+	SearchStats() = default;
+
+	static constexpr bool enabled =
+#if defined(__SEARCH_STATS__)
+		true;
+#else
+		false;
+#endif
+
+	inline void clear() noexcept {
+		*this = SearchStats();
+	}
+
+	// percentage of given part, safe for empty counters
+	static inline double percent(ULL part, ULL total) noexcept {
+		return total ? 100. * part / total : 0.;
+	}
+
+	// single-line summary of collected statistics
+	std::string summary() const {
+		if constexpr (!enabled)
+			return "search statistics not compiled in (define __SEARCH_STATS__)";
+
+		const ULL total_nodes = main_nodes + qnodes;
+		std::ostringstream res;
+
+		res << std::fixed << std::setprecision(2)
+			<< "nodes " << total_nodes
+			<< " qnodes% " << percent(qnodes, total_nodes)
+			<< " qchecks " << qcheck_searches
+			<< " ttprobes " << tt_probes
+			<< " tthits% " << percent(tt_hits, tt_probes)
+			<< " ttcuts " << tt_cutoffs
+			<< " failhigh " << fail_high
+			<< " firstfh% " << percent(fail_high_first, fail_high)
+			<< " nullprune " << null_prunes
+			<< " futprune " << futility_prunes
+			<< " rfp " << reverse_futility_prunes
+			<< " lmp " << lmp_prunes
+			<< " razor " << razor_reductions
+			<< " iir " << iir_reductions
+			<< " probcut " << probcut_prunes << '/' << probcut_searches
+			<< " singular " << singular_extensions << '/' << singular_searches
+			<< " multicut " << multi_cuts
+			<< " lmr " << lmr_searches
+			<< " lmrresearch " << lmr_researches
+			<< " branching " << (main_nodes ? 1. * searched_moves / main_nodes : 0.);
+
+		return res.str();
+	}
+
+	// transposition table usage
+	ULL tt_probes = 0, tt_hits = 0, tt_cutoffs = 0;
+
+	// move ordering quality
+	ULL fail_high = 0, fail_high_first = 0;
+
+	// selectivity
+	ULL null_prunes = 0, futility_prunes = 0, reverse_futility_prunes = 0, lmp_prunes = 0,
+		razor_reductions = 0, iir_reductions = 0, probcut_searches = 0, probcut_prunes = 0,
+		singular_searches = 0, singular_extensions = 0, multi_cuts = 0,
+		lmr_searches = 0, lmr_researches = 0;
+
+	// tree shape - interior nodes, quiescence nodes, moves searched in interior nodes
+	// and quiet checks searched on the first quiescence ply
+	ULL main_nodes = 0, qnodes = 0, searched_moves = 0, qcheck_searches = 0;
+};
@@ -0,0 +1,403 @@
+#include "SelfPlay.h"
+#include "Batch.h"
+#include "BitBoardsSet.h"
+#include "MoveGeneration.h"
+#include "MoveOrder.h"
+#include "Search.h"
+#include "Zobrist.h"
+#include "UCI.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+	static constexpr int
+		// games longer than that are adjudicated as draws
+		max_plies = 400,
+		// game is adjudicated once score of the searching side is beyond resign score for resign plies in a row
+		resign_score = 1000,
+		resign_plies = 6,
+		mate_value = 30000,
+		// length of random openings played without an openings file
+		random_plies = 8,
+		// random openings are drawn again, unless a search of that depth scores them within the margin
+		opening_depth = 6,
+		opening_margin = 100;
+
+	// budget of a single move - clock (base and increment), fixed time or fixed nodes
+	struct Control {
+		int base = 0, inc = 0, movetime = 0;
+		ULL nodes = 10000;
+	};
+
+	// uci options as (name, value) pairs
+	using Options = std::vector<std::pair<std::string, std::string>>;
+
+	struct Player {
+		TranspositionTable table;
+		mOrder order;
+		// every option set by any of the players, so switching players leaves nothing of the other one
+		Options options;
+		size_t hash_MB = 16;
+		Control control;
+	};
+
+	std::array<Player, 2> players;
+
+	// player's tables become the tables of the global search and the other way round
+	void swapIn(Player& p) {
+		std::swap(tt, p.table);
+		m_search.move_order.swap(p.order);
+	}
+
+	void applyOptions(const Options& options) {
+		for (const auto& [name, value] : options) {
+			// the same arguments as the ones following 'setoption' command
+			std::istringstream strm("name " + name + " value " + value);
+			UCI_o.setOption(strm);
+		}
+	}
+
+	inline bool insufficientMaterial() {
+		return !(BBs[nWhitePawn] | BBs[nBlackPawn] | BBs[nWhiteRook] | BBs[nBlackRook] | BBs[nWhiteQueen] | BBs[nBlackQueen])
+			and bitCount(BBs[nWhiteKnight] | BBs[nBlackKnight] | BBs[nWhiteBishop] | BBs[nBlackBishop]) <= 1;
+	}
+
+	// score of the side to move from uci score string
+	inline int scoreValue(const std::string& score) {
+		std::istringstream strm(score);
+		std::string type;
+		int value = 0;
+
+		strm >> type >> value;
+		return type == "mate" ? (value > 0 ? mate_value : -mate_value) : value;
+	}
+
+	struct GameResult {
+		// points of the first player doubled - 0 loss, 1 draw, 2 win
+		int points;
+		std::string reason;
+	};
+
+	// uniformly random legal moves from given position - drawn again, if they end the game or leave
+	// one side clearly ahead, as both games of the pair would be decided by the opening then
+	std::vector<MoveItem::iMove> randomOpening(const std::string& fen, std::mt19937_64& rng) {
+		std::vector<MoveItem::iMove> moves;
+		MoveList ml;
+
+		while (true) {
+			BBs.parseFEN(fen);
+			moves.clear();
+
+			for (int i = 0; i < random_plies; i++) {
+				MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+				if (!ml.size()) break;
+
+				moves.push_back(ml[std::uniform_int_distribution<size_t>(0, ml.size() - 1)(rng)]);
+				MovePerform::makeMove(moves.back());
+			}
+
+			MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+			if (ml.size() and std::abs(scoreValue(Batch::analyse({ Batch::Limit::DEPTH, opening_depth }).score)) <= opening_margin)
+				return moves;
+		}
+	}
+
+	GameResult playGame(const std::string& fen, const std::vector<MoveItem::iMove>& opening, const bool first_white) {
+		BBs.parseFEN(fen);
+		rep_tt.clear();
+
+		MoveItem::iMove last = MoveItem::iMove::no_move;
+
+		for (const auto move : opening) {
+			rep_tt.posRegister();
+			MovePerform::makeMove(move);
+			last = move;
+		}
+
+		for (auto& p : players) {
+			swapIn(p);
+			tt.setSize(p.hash_MB);
+			m_search.move_order.clearHistory();
+			m_search.move_order.clearCountermove();
+			swapIn(p);
+		}
+
+		std::array<int, 2> clock = { players[0].control.base, players[1].control.base };
+		int resign_count = 0, resign_winner = -1, applied = -1;
+
+		for (int ply = 0; ; ply++) {
+			// index of the player to move
+			const int pl = (game_state.turn == WHITE) != first_white;
+			const auto lost = [pl](std::string reason) { return GameResult{ pl ? 2 : 0, reason }; };
+
+			MoveList ml;
+			MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+
+			if (!ml.size()) {
+				return isSquareAttacked(getLS1BIndex(BBs[nWhiteKing + game_state.turn]), game_state.turn)
+					? lost("checkmate") : GameResult{ 1, "stalemate" };
+			}
+			else if (rep_tt.isRepetition())
+				return { 1, "repetition" };
+			else if (game_state.halfmove >= 2 * gState::MAX_MOVE_RULE)
+				return { 1, "50 moves" };
+			else if (insufficientMaterial())
+				return { 1, "insufficient material" };
+			else if (ply >= max_plies)
+				return { 1, "max length" };
+
+			Player& p = players[pl];
+			const Control& ctrl = p.control;
+
+			swapIn(p);
+			if (applied != pl) applyOptions(p.options), applied = pl;
+
+			if (ctrl.base) m_search.time_data.calcMoveTime(clock[pl], ctrl.inc);
+			else m_search.time_data.setFixedTime(ctrl.movetime);
+			m_search.time_data.setNodeLimit(ctrl.nodes);
+			m_search.prev_move = last;
+
+			const Batch::Result res = Batch::search(mSearch::max_depth);
+			swapIn(p);
+
+			if (ctrl.base) {
+				if ((clock[pl] -= static_cast<int>(res.time)) < 0)
+					return lost("time forfeit");
+				clock[pl] += ctrl.inc;
+			}
+
+			const auto move = std::find_if(ml.begin(), ml.end(), [&res](const MoveItem::iMove m) {
+				return std::string(index_to_square[m.getOrigin()]) + index_to_square[m.getTarget()]
+					+ (m.getPromo() ? std::string(1, " nbrq"[m.getPromo()]) : "") == res.best_move;
+			});
+
+			if (move == ml.end())
+				return lost("illegal move");
+
+			// both players have to agree - winning side sees high score and losing side low score on it's moves
+			const int score = scoreValue(res.score);
+			const int winner = score >= resign_score ? pl : score <= -resign_score ? !pl : -1;
+
+			resign_count = winner != -1 and winner == resign_winner ? resign_count + 1 : winner != -1;
+			resign_winner = winner;
+
+			if (resign_count >= resign_plies)
+				return { winner == 0 ? 2 : 0, "adjudication" };
+
+			rep_tt.posRegister();
+			MovePerform::makeMove(*move);
+			last = *move;
+		}
+	}
+
+	// sequential probability ratio test of a trinomial (win, draw, loss) result, Elo in logistic scale
+	struct Sprt {
+		double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+
+		static inline double scoreOf(const double elo) { return 1. / (1. + std::pow(10., -elo / 400.)); }
+		static inline double eloOf(const double score) { return -400. * std::log10(1. / score - 1.); }
+
+		inline double lowerBound() const { return std::log(beta / (1. - alpha)); }
+		inline double upperBound() const { return std::log((1. - beta) / alpha); }
+
+		// log-likelihood ratio - normal approximation of the score distribution
+		double llr(const int w, const int d, const int l) const {
+			const double n = w + d + l, s = (w + d / 2.) / n;
+			const double var = (w * (1 - s) * (1 - s) + d * (0.5 - s) * (0.5 - s) + l * s * s) / n;
+			const double s0 = scoreOf(elo0), s1 = scoreOf(elo1);
+
+			return var > 0 ? n * (s1 - s0) * (2 * s - s0 - s1) / (2 * var) : 0.;
+		}
+
+		// Elo difference and its 95% confidence margin
+		static std::pair<double, double> elo(const int w, const int d, const int l) {
+			const double n = w + d + l, s = std::clamp((w + d / 2.) / n, 1e-3, 1 - 1e-3);
+			const double var = (w * (1 - s) * (1 - s) + d * (0.5 - s) * (0.5 - s) + l * s * s) / n;
+			const double margin = 1.96 * std::sqrt(var / n);
+
+			return { eloOf(s), (eloOf(std::min(s + margin, 1 - 1e-3)) - eloOf(std::max(s - margin, 1e-3))) / 2 };
+		}
+	};
+
+	inline const char* pgnResult(const int points, const bool first_white) {
+		return points == 1 ? "1/2-1/2" : (points == 2) == first_white ? "1-0" : "0-1";
+	}
+
+} // namespace
+
+
+void SelfPlay::run(std::istream& args) {
+	std::string key, openings_path;
+	std::vector<std::string> openings;
+	int games = 100, workers_num = 1;
+	ULL seed = std::random_device()();
+	double odds = 1.;
+	Control control;
+	Sprt sprt;
+
+	for (auto& p : players) {
+		p.options.clear();
+		p.hash_MB = 16;
+	}
+
+	while (args >> key) {
+		if (key == "openings")      args >> openings_path;
+		else if (key == "games")    args >> games;
+		else if (key == "workers")  args >> workers_num;
+		else if (key == "odds")     args >> odds;
+		else if (key == "seed")     args >> seed;
+		else if (key == "elo0")     args >> sprt.elo0;
+		else if (key == "elo1")     args >> sprt.elo1;
+		else if (key == "alpha")    args >> sprt.alpha;
+		else if (key == "beta")     args >> sprt.beta;
+		else if (key == "hash") {
+			args >> players[0].hash_MB;
+			players[1].hash_MB = players[0].hash_MB;
+		}
+		else if (key == "nodes")    control = Control(), args >> control.nodes;
+		else if (key == "movetime") control = Control(), control.nodes = 0, args >> control.movetime;
+		else if (key == "tc")       control = Control(), control.nodes = 0, args >> control.base >> control.inc;
+		else if (key == "option1" or key == "option2") {
+			Player& p = players[key == "option2"];
+			std::string name, value;
+			args >> name >> value;
+
+			// every player has it's own transposition table, so hash size isn't a global option here
+			if (name == "Hash") p.hash_MB = std::stoi(value);
+			else p.options.emplace_back(name, value);
+		}
+	}
+
+	// options set by only one of the players keep the value from before the match for the other one -
+	// the values are restored once the match is over
+	Options prev_options;
+	const auto has = [](const Options& options, const std::string& name) {
+		return std::any_of(options.begin(), options.end(), [&name](const auto& o) { return o.first == name; });
+	};
+
+	for (const auto& p : players)
+		for (const auto& [name, value] : p.options)
+			if (!has(prev_options, name)) prev_options.emplace_back(name, UCI_o.getOption(name));
+
+	for (auto& p : players)
+		for (const auto& option : prev_options)
+			if (!has(p.options, option.first)) p.options.push_back(option);
+
+	if (!openings_path.empty()) {
+		std::ifstream src(openings_path);
+		Batch::Position pos;
+
+		for (std::string line; std::getline(src, line); )
+			if (Batch::parseEPD(line, pos)) openings.push_back(pos.fen);
+
+		if (openings.empty()) {
+			OS << "info string no openings found in '" << openings_path << "'\n";
+			return;
+		}
+	}
+	else {
+		// the same game would be played by every pair with deterministic limits - 
+		// start each pair from a different random opening instead
+		OS << "info string no openings file, game pairs start with " << random_plies
+			<< " random plies from the start position (seed " << seed << ")\n";
+		openings.push_back(BitBoardsSet::start_pos);
+	}
+
+	const bool random_openings = openings_path.empty();
+
+	players[0].control = players[1].control = control;
+	players[1].control.base = static_cast<int>(control.base * odds);
+	players[1].control.inc = static_cast<int>(control.inc * odds);
+	players[1].control.movetime = static_cast<int>(control.movetime * odds);
+	players[1].control.nodes = static_cast<ULL>(control.nodes * odds);
+
+	// one job per game pair, openings are repeated if there is less of them than pairs
+	const int pairs = (std::max(games, 2) + 1) / 2;
+	std::ostringstream jobs_text;
+
+	for (int i = 0; i < pairs; i++)
+		jobs_text << openings[i % openings.size()] << '\n';
+
+	std::istringstream jobs(jobs_text.str());
+
+	OS << "selfplay " << pairs << " game pairs, " << (random_openings ? "random" : std::to_string(openings.size())) << " openings, "
+		<< "SPRT elo0 " << sprt.elo0 << " elo1 " << sprt.elo1 << " alpha " << sprt.alpha << " beta " << sprt.beta << '\n';
+
+	const size_t prev_hash_MB = tt.sizeMB();
+
+	const auto job = [random_openings, seed, &prev_options](const size_t index, const std::string& fen) {
+		std::mt19937_64 rng(seed + index);
+		// openings are checked with the options from before the match, not the ones of the last player
+		if (random_openings) applyOptions(prev_options);
+		const std::vector<MoveItem::iMove> opening = random_openings ? randomOpening(fen, rng) : std::vector<MoveItem::iMove>();
+		const GameResult first = playGame(fen, opening, true), second = playGame(fen, opening, false);
+		return std::to_string(index) + ' ' + std::to_string(first.points) + ' ' + std::to_string(second.points)
+			+ ' ' + first.reason + ';' + second.reason;
+	};
+
+	int w = 0, d = 0, l = 0, played_pairs = 0;
+	bool decided = false;
+
+	const auto sink = [&](const std::string& output) {
+		std::istringstream strm(output);
+		std::string reasons;
+		size_t index;
+		int first, second;
+
+		// results of pairs still played by other workers after the decision are ignored
+		if (decided or !(strm >> index >> first >> second))
+			return !decided;
+
+		std::getline(strm >> std::ws, reasons);
+		const size_t sep = reasons.find(';');
+
+		for (const int points : { first, second })
+			points == 2 ? w++ : points == 1 ? d++ : l++;
+
+		const auto [elo, margin] = Sprt::elo(w, d, l);
+		const double llr = sprt.llr(w, d, l);
+
+		OS << "Pair " << std::setw(4) << ++played_pairs << ": "
+			<< pgnResult(first, true) << ' ' << reasons.substr(0, sep) << ", "
+			<< pgnResult(second, false) << ' ' << reasons.substr(sep + 1)
+			<< " | +" << w << " =" << d << " -" << l
+			<< std::fixed << std::setprecision(1) << " | Elo " << elo << " +/- " << margin
+			<< std::setprecision(2) << " | LLR " << llr << " [" << sprt.lowerBound() << ", " << sprt.upperBound() << "]"
+			<< std::defaultfloat << std::endl;
+
+		if (llr >= sprt.upperBound() or llr <= sprt.lowerBound()) {
+			OS << "SPRT: H" << (llr >= sprt.upperBound()) << " accepted\n";
+			decided = true;
+		}
+
+		return !decided;
+	};
+
+	Batch::dispatch(jobs, job, sink, workers_num);
+
+	const auto [elo, margin] = Sprt::elo(w, d, l);
+	OS << "===========================\n"
+		<< "Games           : " << w + d + l << " (+" << w << " =" << d << " -" << l << ")\n"
+		<< std::fixed << std::setprecision(1)
+		<< "Elo             : " << elo << " +/- " << margin << '\n'
+		<< std::setprecision(2)
+		<< "LLR             : " << sprt.llr(w, d, l) << (decided ? "" : " (SPRT not decided)") << '\n'
+		<< std::defaultfloat;
+
+	// restore engine state
+	applyOptions(prev_options);
+	tt.setSize(prev_hash_MB);
+	m_search.move_order.clearHistory();
+	m_search.move_order.clearCountermove();
+	rep_tt.clear();
+	BBs.parseFEN(BitBoardsSet::start_pos);
+}
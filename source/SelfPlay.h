@@ -0,0 +1,17 @@
+#pragma once
+
+#include <istream>
+
+
+// self-play matches between two engine configurations. Game pairs with swapped colors are played from every
+// opening, pairs are dispatched between worker processes like batch analysis jobs. Each player keeps its own
+// transposition table and move ordering histories, which are swapped into the global search before it's move
+namespace SelfPlay {
+
+	// 'selfplay [openings <file>] [games N] [workers N] [nodes N | movetime N | tc <base ms> <inc ms>] [odds F]
+	// [hash MB] [option1 <name> <value>]... [option2 <name> <value>]... [elo0 E] [elo1 E] [alpha A] [beta B] [seed N]' -
+	// time/node budget of the second player is multiplied by odds, match stops once SPRT(elo0, elo1) is decided.
+	// Without openings file every pair starts with random plies from the start position, drawn with given seed
+	void run(std::istream& args);
+
+} // namespace SelfPlay
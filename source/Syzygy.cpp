@@ -0,0 +1,1085 @@
+#include "Syzygy.h"
+#include "UCI.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+	using namespace Syzygy;
+
+	// kings included
+	constexpr int tb_pieces = 7;
+
+	// table piece code - piece type + 1, black pieces with additional 8
+	inline constexpr int tbCode(const int type, const bool side) noexcept {
+		return (type + 1) | (side << 3);
+	}
+
+	inline int fileOf(const int sq) noexcept { return sq & 7; }
+	inline int rankOf(const int sq) noexcept { return sq >> 3; }
+
+	// below (negative), on (zero) or above (positive) a1-h8 diagonal
+	inline int diagonalSide(const int sq) noexcept { return rankOf(sq) - fileOf(sq); }
+
+	inline int distance(const int sq1, const int sq2) noexcept {
+		return std::max(std::abs(fileOf(sq1) - fileOf(sq2)), std::abs(rankOf(sq1) - rankOf(sq2)));
+	}
+
+	inline int read8(const uint8_t* p) noexcept { return p[0]; }
+	inline int read16le(const uint8_t* p) noexcept { return p[0] | (p[1] << 8); }
+	inline uint32_t read32le(const uint8_t* p) noexcept {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+	}
+
+	inline int zeroingDtz(const int wdl) noexcept {
+		static constexpr std::array<int, 5> dtz = { -1, -101, 0, 101, 1 };
+		return dtz[wdl + 2];
+	}
+
+
+	// squares and pieces numbering shared by all tables
+	struct Indexing {
+		// binomial[k][n] - ways to choose k of n squares
+		std::array<std::array<uint64_t, 64>, tb_pieces> binomial{};
+		// a1-d1-d4 triangle - squares below the diagonal first (0..5), then diagonal squares (6..9)
+		std::array<int, 64> triangle{};
+		// squares below a1-h8 diagonal (0..27)
+		std::array<int, 64> lower{};
+		// 462 placements of two kings, the first one in the triangle, not above the diagonal if both are on it
+		std::array<std::array<int, 64>, 10> kings{};
+		// pawn squares a2-h7 (47..0) - files from the edge inwards, ranks from the second one
+		std::array<int, 64> pawn{};
+		// index of leading pawns by their count and square of the first one, and their count per file
+		std::array<std::array<uint64_t, 64>, tb_pieces> lead_pawns{};
+		std::array<std::array<uint64_t, 4>, tb_pieces> lead_pawns_size{};
+
+		Indexing() {
+			for (int n = 0; n < 64; n++) {
+				binomial[0][n] = 1;
+				for (int k = 1; k < tb_pieces and n > 0; k++)
+					binomial[k][n] = binomial[k - 1][n - 1] + binomial[k][n - 1];
+			}
+
+			triangle.fill(-1);
+			int below = 0, diagonal = 6, lower_sq = 0;
+			for (int sq = 0; sq < 64; sq++) {
+				if (diagonalSide(sq) < 0)
+					lower[sq] = lower_sq++;
+
+				if (fileOf(sq) <= 3 and rankOf(sq) <= 3 and diagonalSide(sq) <= 0)
+					triangle[sq] = diagonalSide(sq) < 0 ? below++ : diagonal++;
+			}
+
+			// kings on the diagonal both are placed last
+			int code = 0;
+			std::vector<std::pair<int, int>> diagonal_kings;
+
+			for (int t = 0; t < 10; t++) {
+				const int k1 = static_cast<int>(std::find_if(triangle.begin(), triangle.begin() + 28,
+					[t](int c) { return c == t; }) - triangle.begin());
+
+				for (int k2 = 0; k2 < 64; k2++) {
+					if (distance(k1, k2) <= 1 or (diagonalSide(k1) == 0 and diagonalSide(k2) > 0))
+						continue;
+
+					if (diagonalSide(k1) == 0 and diagonalSide(k2) == 0)
+						diagonal_kings.emplace_back(t, k2);
+					else
+						kings[t][k2] = code++;
+				}
+			}
+
+			for (const auto& [t, k2] : diagonal_kings)
+				kings[t][k2] = code++;
+
+			code = 47;
+			for (int f = 0; f <= 3; f++) {
+				for (int r = 1; r <= 6; r++) {
+					pawn[8 * r + f] = code--;
+					pawn[(8 * r + f) ^ 7] = code--;
+				}
+			}
+
+			for (int cnt = 1; cnt < tb_pieces; cnt++) {
+				for (int f = 0; f <= 3; f++) {
+					uint64_t idx = 0;
+
+					for (int r = 1; r <= 6; r++) {
+						lead_pawns[cnt][8 * r + f] = idx;
+						idx += binomial[cnt - 1][pawn[8 * r + f]];
+					}
+
+					lead_pawns_size[cnt][f] = idx;
+				}
+			}
+		}
+	};
+
+	const Indexing& indexing() {
+		static const Indexing ix;
+		return ix;
+	}
+
+
+	// read-only mapping of a whole file
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile() {
+			if (!base)
+				return;
+#if defined(_WIN32)
+			UnmapViewOfFile(base);
+			CloseHandle(handle);
+#else
+			munmap(const_cast<uint8_t*>(base), length);
+#endif
+		}
+
+		bool open(const std::string& path) {
+#if defined(_WIN32)
+			const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER size;
+			GetFileSizeEx(file, &size);
+			length = static_cast<size_t>(size.QuadPart);
+			handle = length ? CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+			CloseHandle(file);
+
+			if (!handle)
+				return false;
+
+			base = static_cast<const uint8_t*>(MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0));
+			if (!base)
+				CloseHandle(handle);
+#else
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd == -1)
+				return false;
+
+			struct stat st;
+			length = fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+			void* addr = length ? mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+			::close(fd);
+
+			if (addr == MAP_FAILED)
+				return false;
+
+			madvise(addr, length, MADV_RANDOM);
+			base = static_cast<const uint8_t*>(addr);
+#endif
+			return base;
+		}
+
+		const uint8_t* data() const noexcept { return base; }
+		size_t size() const noexcept { return length; }
+
+	private:
+		const uint8_t* base = nullptr;
+		size_t length = 0;
+#if defined(_WIN32)
+		HANDLE handle = nullptr;
+#endif
+	};
+
+
+	// flags of a single values stream
+	enum StreamFlag : uint8_t {
+		DTZ_BLACK_TO_MOVE = 1, DTZ_MAPPED = 2, DTZ_WIN_PLIES = 4, DTZ_LOSS_PLIES = 8, DTZ_WIDE_MAP = 16, SINGLE_VALUE = 128
+	};
+
+	// Values of a table in index order, compressed with a canonical huffman code. Every symbol stands for
+	// a value or for a pair of other symbols, so it expands into one or more values. Blocks of fixed size
+	// hold a variable number of values, a sparse index gives the block and offset of every span-th value.
+	struct Stream {
+		uint8_t flags = 0;
+		int single_value = 0;
+		int min_len = 0, max_len = 0;
+		uint64_t block_bytes = 0, span = 0, sparse_entries = 0;
+		uint32_t blocks = 0, block_entries = 0;
+		// lowest symbol of every code length
+		std::vector<int> lowest;
+		// lowest code of every code length, codes of the same length are consecutive
+		std::vector<uint64_t> first_code;
+		// 12 bits of the left and 12 bits of the right symbol of each pair, right one is 0xFFF for values
+		const uint8_t* pairs = nullptr;
+		// number of values minus one expanded from each symbol
+		std::vector<uint32_t> expanded;
+		const uint8_t* sparse = nullptr;
+		const uint8_t* block_length = nullptr;
+		const uint8_t* data = nullptr;
+
+		int left(const int sym) const noexcept {
+			return pairs[3 * sym] | ((pairs[3 * sym + 1] & 0xF) << 8);
+		}
+
+		int right(const int sym) const noexcept {
+			return (pairs[3 * sym + 1] >> 4) | (pairs[3 * sym + 2] << 4);
+		}
+
+		uint32_t blockValues(const int64_t block) const noexcept {
+			return read16le(block_length + 2 * block) + 1;
+		}
+
+		// read stream description, values count is needed for the sparse index size
+		const uint8_t* parse(const uint8_t* p, const uint8_t* end, const uint64_t values) {
+			if (end - p < 2)
+				return nullptr;
+
+			flags = *p++;
+			if (flags & SINGLE_VALUE) {
+				single_value = *p++;
+				return p;
+			}
+
+			if (end - p < 10)
+				return nullptr;
+
+			block_bytes = 1ULL << read8(p);
+			span = 1ULL << read8(p + 1);
+			const int padding = read8(p + 2);
+			blocks = read32le(p + 3);
+			block_entries = blocks + padding;
+			max_len = read8(p + 7);
+			min_len = read8(p + 8);
+			p += 9;
+			sparse_entries = (values + span - 1) / span;
+
+			if (min_len < 1 or max_len < min_len or max_len > 32 or end - p < 2 * (max_len - min_len + 1) + 2)
+				return nullptr;
+
+			lowest.resize(max_len + 1);
+			for (int len = min_len; len <= max_len; len++, p += 2)
+				lowest[len] = read16le(p);
+
+			// symbols of length l + 1 directly precede symbols of length l, longest codes start at 0
+			first_code.assign(max_len + 1, 0);
+			for (int len = max_len - 1; len >= min_len; len--)
+				first_code[len] = static_cast<uint64_t>(first_code[len + 1] + lowest[len] - lowest[len + 1]) / 2;
+
+			const int symbols = read16le(p);
+			p += 2;
+			if (symbols > 0xFFF or end - p < 3 * symbols + (symbols & 1))
+				return nullptr;
+
+			pairs = p;
+			expanded.assign(symbols, UINT32_MAX);
+			for (int sym = 0; sym < symbols; sym++) {
+				if (expandedCount(sym, 0) == UINT32_MAX)
+					return nullptr;
+			}
+
+			return p + 3 * symbols + (symbols & 1);
+		}
+
+		// values count of a symbol - pairs can't be nested deeper than symbols count
+		uint32_t expandedCount(const int sym, const int nesting) {
+			if (expanded[sym] != UINT32_MAX or nesting > static_cast<int>(expanded.size()))
+				return expanded[sym];
+
+			if (right(sym) == 0xFFF)
+				return expanded[sym] = 0;
+
+			if (left(sym) >= static_cast<int>(expanded.size()) or right(sym) >= static_cast<int>(expanded.size()))
+				return UINT32_MAX;
+
+			const uint32_t l = expandedCount(left(sym), nesting + 1), r = expandedCount(right(sym), nesting + 1);
+			if (l == UINT32_MAX or r == UINT32_MAX)
+				return UINT32_MAX;
+
+			return expanded[sym] = l + r + 1;
+		}
+
+		int value(const uint64_t idx) const {
+			if (flags & SINGLE_VALUE)
+				return single_value;
+
+			// sparse index entry points to the value in the middle of its span
+			const uint8_t* entry = sparse + 6 * (idx / span);
+			int64_t block = read32le(entry);
+			int64_t pos = read16le(entry + 4) + static_cast<int64_t>(idx % span) - static_cast<int64_t>(span / 2);
+
+			while (pos < 0)
+				pos += blockValues(--block);
+
+			while (pos >= blockValues(block))
+				pos -= blockValues(block++);
+
+			// codes are read from the most significant bit, bits past the block are zeros
+			const uint8_t* ptr = data + block * block_bytes;
+			const uint8_t* const block_end = ptr + block_bytes;
+			uint64_t bits = 0;
+			int bits_count = 0;
+
+			const auto refill = [&]() {
+				for (; bits_count <= 56; bits_count += 8)
+					bits |= static_cast<uint64_t>(ptr < block_end ? *ptr++ : 0) << (56 - bits_count);
+			};
+
+			int sym;
+			while (true) {
+				refill();
+
+				// the shortest length, which code is not below the first code of its length
+				int len = min_len;
+				while ((bits >> (64 - len)) < first_code[len])
+					len++;
+
+				sym = lowest[len] + static_cast<int>((bits >> (64 - len)) - first_code[len]);
+
+				if (pos <= expanded[sym])
+					break;
+
+				pos -= expanded[sym] + 1;
+				bits <<= len;
+				bits_count -= len;
+			}
+
+			// descend the pairs to the value
+			while (right(sym) != 0xFFF) {
+				const int l = left(sym);
+
+				if (pos <= expanded[l])
+					sym = l;
+				else {
+					pos -= expanded[l] + 1;
+					sym = right(sym);
+				}
+			}
+
+			return left(sym);
+		}
+	};
+
+
+	// order of pieces and their groups in the index of one stream
+	struct Layout {
+		std::array<int, tb_pieces> piece{};
+		std::array<int, tb_pieces> group_len{};
+		std::array<uint64_t, tb_pieces> factor{};
+		int groups = 0;
+		uint64_t size = 0;
+	};
+
+	// material of a table - piece count per side and piece type, kings excluded
+	using Material = std::array<std::array<int, KING>, 2>;
+
+	U64 materialKey(const Material& m, const bool swap) {
+		U64 key = 0;
+
+		for (int side = 0; side < 2; side++)
+			for (int type = PAWN; type < KING; type++)
+				key |= U64(m[side ^ swap][type]) << (4 * (type + KING * side));
+
+		return key;
+	}
+
+	// WDL or DTZ file of a table, loaded at first access
+	struct TableFile {
+		bool loaded = false, valid = false;
+		MappedFile file;
+		// WDL values stored for both sides to move
+		bool split = false;
+		// [leading pawn file][side to move]
+		std::array<std::array<Layout, 2>, 4> layout;
+		std::array<std::array<Stream, 2>, 4> stream;
+		// DTZ values maps - win, loss, cursed win and blessed loss per leading pawn file
+		const uint8_t* map = nullptr;
+		std::array<std::array<uint32_t, 4>, 4> map_start{};
+	};
+
+	struct Table {
+		std::string name;
+		Material material{};
+		int pieces = 0;
+		bool pawns = false, symmetric = false, unique = false;
+		// side with fewer pawns (white if equal) leads, other pawns form the second group if it has any
+		bool lead_side = WHITE, both_pawns = false;
+		TableFile wdl, dtz;
+	};
+
+	std::vector<std::unique_ptr<Table>> tables;
+	// tables by material key of either color
+	std::unordered_map<U64, Table*> table_keys;
+	std::vector<std::string> table_dirs;
+
+	// fill piece groups and factors of one stream from piece order and groups order
+	void setLayout(const Table& t, Layout& l, const std::array<int, 2>& order, const int file) {
+		const Indexing& ix = indexing();
+		int i = t.pawns ? t.material[t.lead_side][PAWN] : t.unique ? 3 : 2;
+
+		l.groups = 0;
+		l.group_len[l.groups++] = i;
+		while (i < t.pieces) {
+			int j = i;
+			while (j < t.pieces and l.piece[j] == l.piece[i]) j++;
+			l.group_len[l.groups++] = j - i;
+			i = j;
+		}
+
+		int next = t.both_pawns ? 2 : 1, free_squares = 64 - l.group_len[0] - (t.both_pawns ? l.group_len[1] : 0);
+		uint64_t factor = 1;
+
+		for (int k = 0; next < l.groups or k == order[0] or k == order[1]; k++) {
+			if (k == order[0]) {
+				l.factor[0] = factor;
+				factor *= t.pawns ? ix.lead_pawns_size[l.group_len[0]][file] : t.unique ? 31332 : 462;
+			}
+			else if (k == order[1]) {
+				l.factor[1] = factor;
+				factor *= ix.binomial[l.group_len[1]][48 - l.group_len[0]];
+			}
+			else {
+				l.factor[next] = factor;
+				factor *= ix.binomial[l.group_len[next]][free_squares];
+				free_squares -= l.group_len[next++];
+			}
+		}
+
+		l.size = factor;
+	}
+
+	const uint8_t* align(const uint8_t* base, const uint8_t* p, const uintptr_t to) {
+		return base + ((static_cast<uintptr_t>(p - base) + to - 1) & ~(to - 1));
+	}
+
+	// parse file header and locate streams of each leading pawn file and side to move
+	bool parseTable(const Table& t, TableFile& tf, const bool dtz) {
+		static constexpr uint8_t wdl_magic[] = { 0x71, 0xE8, 0x23, 0x5D }, dtz_magic[] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+		const uint8_t* const base = tf.file.data();
+		const uint8_t* const end = base + tf.file.size();
+		const uint8_t* p = base;
+
+		if (tf.file.size() < 8 or !std::equal(p, p + 4, dtz ? dtz_magic : wdl_magic))
+			return false;
+
+		p += 4;
+		const int header = *p++;
+		tf.split = !dtz and (header & 1);
+
+		if (bool(header & 2) != t.pawns)
+			return false;
+
+		const int files = t.pawns ? 4 : 1, sides = tf.split ? 2 : 1;
+
+		// groups order and pieces order - low nibbles for white to move, high ones for black to move
+		for (int f = 0; f < files; f++) {
+			if (end - p < 1 + t.both_pawns + t.pieces)
+				return false;
+
+			const int order = p[0], pawns_order = t.both_pawns ? p[1] : 0xFF;
+			p += 1 + t.both_pawns;
+
+			for (int side = 0; side < sides; side++) {
+				Layout& l = tf.layout[f][side];
+				const int shift = 4 * side;
+
+				for (int k = 0; k < t.pieces; k++)
+					l.piece[k] = (p[k] >> shift) & 0xF;
+
+				setLayout(t, l, { (order >> shift) & 0xF, (pawns_order >> shift) & 0xF }, f);
+			}
+
+			p += t.pieces;
+		}
+
+		p = align(base, p, 2);
+
+		for (int f = 0; f < files; f++) {
+			for (int side = 0; side < sides; side++) {
+				if (!(p = tf.stream[f][side].parse(p, end, tf.layout[f][side].size)))
+					return false;
+			}
+		}
+
+		// DTZ values ordered by frequency are mapped back to distances
+		if (dtz) {
+			tf.map = p;
+
+			for (int f = 0; f < files; f++) {
+				const Stream& s = tf.stream[f][0];
+				if (!(s.flags & DTZ_MAPPED))
+					continue;
+
+				if (s.flags & DTZ_WIDE_MAP) {
+					p = align(base, p, 2);
+					for (int i = 0; i < 4 and end - p >= 2; i++) {
+						tf.map_start[f][i] = static_cast<uint32_t>((p - tf.map) / 2 + 1);
+						p += 2 + 2 * read16le(p);
+					}
+				}
+				else {
+					for (int i = 0; i < 4 and end - p >= 1; i++) {
+						tf.map_start[f][i] = static_cast<uint32_t>(p - tf.map + 1);
+						p += 1 + read8(p);
+					}
+				}
+			}
+
+			p = align(base, p, 2);
+		}
+
+		for (int f = 0; f < files; f++)
+			for (int side = 0; side < sides; side++)
+				tf.stream[f][side].sparse = p, p += 6 * tf.stream[f][side].sparse_entries;
+
+		for (int f = 0; f < files; f++)
+			for (int side = 0; side < sides; side++)
+				tf.stream[f][side].block_length = p, p += 2 * uint64_t(tf.stream[f][side].block_entries);
+
+		for (int f = 0; f < files; f++) {
+			for (int side = 0; side < sides; side++) {
+				p = align(base, p, 64);
+				tf.stream[f][side].data = p;
+				p += tf.stream[f][side].blocks * tf.stream[f][side].block_bytes;
+			}
+		}
+
+		return p <= end;
+	}
+
+	// map the file at first access, false if it's missing or corrupted
+	bool ready(const Table& t, TableFile& tf, const bool dtz) {
+		if (tf.loaded)
+			return tf.valid;
+
+		tf.loaded = true;
+		const std::string fname = t.name + (dtz ? ".rtbz" : ".rtbw");
+
+		for (const auto& dir : table_dirs) {
+			if (!tf.file.open((std::filesystem::path(dir) / fname).string()))
+				continue;
+
+			if (!(tf.valid = parseTable(t, tf, dtz)))
+				OS << "info string corrupted tablebase file " << fname << std::endl;
+			break;
+		}
+
+		return tf.valid;
+	}
+
+
+	// index of the position in a stream, squares in table order - leading group first
+	uint64_t encode(const Table& t, const Layout& l, std::array<int, tb_pieces>& sq) {
+		const Indexing& ix = indexing();
+		const int lead = l.group_len[0];
+		uint64_t idx;
+
+		// leading piece mapped to a-d files
+		if (fileOf(sq[0]) > 3)
+			for (int i = 0; i < t.pieces; i++) sq[i] ^= 7;
+
+		if (t.pawns) {
+			// remaining leading pawns are ordered by their pawn codes, all lower than the first one
+			std::sort(sq.begin() + 1, sq.begin() + lead, [&ix](int a, int b) { return ix.pawn[a] < ix.pawn[b]; });
+			idx = ix.lead_pawns[lead][sq[0]];
+
+			for (int i = 1; i < lead; i++)
+				idx += ix.binomial[i][ix.pawn[sq[i]]];
+		}
+		else {
+			// leading piece mapped to the a1-d1-d4 triangle, then first piece off the diagonal below it
+			if (rankOf(sq[0]) > 3)
+				for (int i = 0; i < t.pieces; i++) sq[i] ^= 56;
+
+			for (int i = 0; i < lead; i++) {
+				if (diagonalSide(sq[i]) == 0)
+					continue;
+
+				if (diagonalSide(sq[i]) > 0)
+					for (int j = 0; j < t.pieces; j++) sq[j] = ((sq[j] & 7) << 3) | (sq[j] >> 3);
+				break;
+			}
+
+			if (t.unique) {
+				const int s0 = sq[0], s1 = sq[1] - (sq[1] > s0), s2 = sq[2] - (sq[2] > sq[0]) - (sq[2] > sq[1]);
+
+				if (diagonalSide(sq[0]))
+					idx = (ix.triangle[sq[0]] * 63 + s1) * 62 + s2;
+				else if (diagonalSide(sq[1]))
+					idx = (6 * 63 + rankOf(s0) * 28 + ix.lower[sq[1]]) * 62 + s2;
+				else if (diagonalSide(sq[2]))
+					idx = 6 * 63 * 62 + 4 * 28 * 62 + (rankOf(s0) * 7 + rankOf(sq[1]) - (sq[1] > s0)) * 28 + ix.lower[sq[2]];
+				else
+					idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+						+ (rankOf(s0) * 7 + rankOf(sq[1]) - (sq[1] > s0)) * 6 + rankOf(sq[2]) - (sq[2] > sq[0]) - (sq[2] > sq[1]);
+			}
+			else idx = ix.kings[ix.triangle[sq[0]]][sq[1]];
+		}
+
+		idx *= l.factor[0];
+
+		// other groups - combination of squares not taken by previous groups, other side pawns on a2-h7
+		for (int g = 1, start = lead; g < l.groups; start += l.group_len[g++]) {
+			const auto first = sq.begin() + start;
+			std::sort(first, first + l.group_len[g]);
+			uint64_t n = 0;
+
+			for (int i = 0; i < l.group_len[g]; i++) {
+				const int taken = static_cast<int>(std::count_if(sq.begin(), first, [&](int s) { return s < first[i]; }));
+				n += ix.binomial[i + 1][first[i] - taken - (g == 1 and t.both_pawns ? 8 : 0)];
+			}
+
+			idx += n * l.factor[g];
+		}
+
+		return idx;
+	}
+
+	// locate the table of the current position and its color orientation
+	Table* findTable(bool& flip) {
+		Material m{};
+
+		for (int side = 0; side < 2; side++)
+			for (int type = PAWN; type < KING; type++)
+				m[side][type] = BBs.count(2 * type + side);
+
+		const U64 key = materialKey(m, false);
+		const auto it = table_keys.find(key);
+
+		if (it == table_keys.end())
+			return nullptr;
+
+		// symmetric tables store white to move only, others white as the first side of table name
+		Table* t = it->second;
+		flip = t->symmetric ? game_state.turn == BLACK : key != materialKey(t->material, false);
+		return t;
+	}
+
+	// stored value of the current position, DTZ converted to plies for given WDL score - false
+	// when a table is missing, or when DTZ table stores the other side to move (other_stm is set then)
+	bool probeTable(const bool dtz, const int wdl, int& value, bool& other_stm) {
+		bool flip;
+		Table* t = findTable(flip);
+		other_stm = false;
+
+		if (!t or !ready(*t, dtz ? t->dtz : t->wdl, dtz))
+			return false;
+
+		const TableFile& tf = dtz ? t->dtz : t->wdl;
+		const int stm = game_state.turn ^ flip, color_flip = flip ? 8 : 0, square_flip = flip ? 56 : 0;
+		std::array<int, tb_pieces> code{}, sq{};
+		int count = 0;
+
+		for (int pc = nWhitePawn; pc <= nBlackKing; pc++) {
+			U64 bb = BBs[pc];
+			while (bb) {
+				sq[count] = popLS1B(bb) ^ square_flip;
+				code[count++] = tbCode(toPieceType(pc), pc & 1) ^ color_flip;
+			}
+		}
+
+		// leading pawn is the one with the highest pawn code, its file selects the stream
+		int file = 0;
+		if (t->pawns) {
+			const int lead_code = tbCode(PAWN, t->lead_side);
+			int lead = -1;
+
+			for (int i = 0; i < count; i++)
+				if (code[i] == lead_code and (lead < 0 or indexing().pawn[sq[i]] > indexing().pawn[sq[lead]])) lead = i;
+
+			std::swap(code[0], code[lead]);
+			std::swap(sq[0], sq[lead]);
+			file = std::min(fileOf(sq[0]), 7 - fileOf(sq[0]));
+		}
+
+		const int side = tf.split ? stm : 0;
+		const Stream& s = tf.stream[file][side];
+
+		// pawnless symmetric DTZ tables serve both sides to move
+		if (dtz and (s.flags & DTZ_BLACK_TO_MOVE) != stm and (t->pawns or !t->symmetric)) {
+			other_stm = true;
+			return false;
+		}
+
+		// pieces in table order, the leading pawn stays first
+		const Layout& l = tf.layout[file][side];
+		for (int i = t->pawns; i < count; i++) {
+			for (int j = i; j < count; j++) {
+				if (code[j] == l.piece[i]) {
+					std::swap(code[i], code[j]);
+					std::swap(sq[i], sq[j]);
+					break;
+				}
+			}
+		}
+
+		value = s.value(encode(*t, l, sq));
+
+		if (!dtz) {
+			value -= 2;
+			return true;
+		}
+
+		// DTZ values are stored ordered by frequency in maps for win, loss, cursed win and blessed loss
+		if (s.flags & DTZ_MAPPED) {
+			static constexpr std::array<int, 5> map_of = { 1, 3, 0, 2, 0 };
+			const uint32_t at = tf.map_start[file][map_of[wdl + 2]] + value;
+			value = s.flags & DTZ_WIDE_MAP ? read16le(tf.map + 2 * uint64_t(at)) : read8(tf.map + at);
+		}
+
+		// and in moves, unless real wins or losses need plies
+		if ((wdl == WDL_WIN and !(s.flags & DTZ_WIN_PLIES)) or (wdl == WDL_LOSS and !(s.flags & DTZ_LOSS_PLIES))
+			or wdl == WDL_CURSED_WIN or wdl == WDL_BLESSED_LOSS)
+			value *= 2;
+
+		return true;
+	}
+
+
+	// make move keeping copies needed to unmake it
+	struct MoveScope {
+		explicit MoveScope(const MoveItem::iMove move)
+			: bbs_cpy(BBs), gstate_cpy(game_state), hash_cpy(hash.key) {
+			MovePerform::makeMove(move);
+		}
+
+		~MoveScope() {
+			MovePerform::unmakeMove(bbs_cpy, gstate_cpy);
+			hash.key = hash_cpy;
+		}
+
+		const BitBoardsSet bbs_cpy;
+		const gState gstate_cpy;
+		const U64 hash_cpy;
+	};
+
+	inline bool inCheck() {
+		return isSquareAttacked(getLS1BIndex(BBs[nWhiteKing + game_state.turn]), game_state.turn);
+	}
+
+	// WDL with captures searched - tables may store any value not above the best capture result,
+	// whichever compresses better
+	int searchWDL(int alpha, const int beta, bool& ok) {
+		if (bitCount(BBs[nOccupied]) == 2)
+			return WDL_DRAW;
+
+		MoveList ml;
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+		size_t captures = 0;
+
+		for (const auto& move : ml) {
+			if (!move.isCapture())
+				continue;
+
+			captures++;
+			int value;
+			{
+				MoveScope scope(move);
+				value = -searchWDL(-beta, -alpha, ok);
+			}
+
+			if (!ok)
+				return WDL_DRAW;
+			else if (value >= beta)
+				return value;
+
+			alpha = std::max(alpha, value);
+		}
+
+		// captures only - stored value is the one of the position without en passant right
+		if (captures and captures == ml.size())
+			return alpha;
+
+		int value;
+		bool other_stm;
+		if (!(ok = probeTable(false, WDL_DRAW, value, other_stm)))
+			return WDL_DRAW;
+
+		return std::max(alpha, value);
+	}
+
+	// WDL, zeroing is set if a zeroing move is the best one - a winning capture, or any move,
+	// when all of them are captures
+	int rootWDL(bool& ok, bool& zeroing) {
+		zeroing = false;
+
+		if (bitCount(BBs[nOccupied]) == 2)
+			return WDL_DRAW;
+
+		MoveList ml;
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+		size_t captures = 0;
+		int best = WDL_LOSS - 1;
+
+		for (const auto& move : ml) {
+			if (!move.isCapture())
+				continue;
+
+			captures++;
+			int value;
+			{
+				MoveScope scope(move);
+				value = -searchWDL(WDL_LOSS, -best, ok);
+			}
+
+			if (!ok)
+				return WDL_DRAW;
+
+			best = std::max(best, value);
+			if (best == WDL_WIN) {
+				zeroing = true;
+				return best;
+			}
+		}
+
+		if (captures and captures == ml.size()) {
+			zeroing = true;
+			return best;
+		}
+
+		int value;
+		bool other_stm;
+		if (!(ok = probeTable(false, WDL_DRAW, value, other_stm)))
+			return WDL_DRAW;
+
+		if (best >= value) {
+			zeroing = best > WDL_DRAW;
+			return best;
+		}
+
+		return value;
+	}
+
+	bool isMate() {
+		MoveList ml;
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+		return !ml.size() and inCheck();
+	}
+
+	// DTZ - zeroing moves are resolved by WDL probes, DTZ table gives the rest
+	int searchDTZ(bool& ok) {
+		bool zeroing;
+		const int wdl = rootWDL(ok, zeroing);
+
+		if (!ok or wdl == WDL_DRAW)
+			return 0;
+		else if (zeroing)
+			return zeroingDtz(wdl);
+
+		MoveList ml;
+		MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+
+		// winning pawn moves - winning captures are known already
+		if (wdl > 0) {
+			for (const auto& move : ml) {
+				if (move.isCapture() or move.getPiece() != PAWN)
+					continue;
+
+				int value;
+				{
+					MoveScope scope(move);
+					value = -rootWDL(ok, zeroing);
+				}
+
+				if (!ok)
+					return 0;
+				else if (value == wdl)
+					return zeroingDtz(wdl);
+			}
+		}
+
+		int dtz;
+		bool other_stm;
+		if (probeTable(true, wdl, dtz, other_stm))
+			return zeroingDtz(wdl) + (wdl > 0 ? dtz : -dtz);
+		else if (!other_stm) {
+			ok = false;
+			return 0;
+		}
+
+		// table stores the other side to move - one ply search, winning side takes the shortest
+		// non-zeroing win, losing side the longest loss
+		int best = wdl > 0 ? INT_MAX : -1;
+
+		for (const auto& move : ml) {
+			const bool zeroing_move = move.isCapture() or move.getPiece() == PAWN;
+			if (wdl > 0 and zeroing_move)
+				continue;
+
+			MoveScope scope(move);
+
+			if (wdl > 0) {
+				if (isMate())
+					return 1;
+
+				const int value = -searchDTZ(ok);
+				if (value > 0)
+					best = std::min(best, value + 1);
+			}
+			// zeroing move keeping blessed loss, other ones are no candidates
+			else if (zeroing_move)
+				best = std::min(best, wdl == WDL_LOSS ? -1 : searchWDL(WDL_CURSED_WIN, WDL_WIN, ok) == WDL_WIN ? 0 : -101);
+			else
+				best = std::min(best, -searchDTZ(ok) - 1);
+
+			if (!ok)
+				return 0;
+		}
+
+		return best;
+	}
+
+	// table name like KRPvKR - a king first on each side, up to 7 pieces
+	void addTable(const std::string& name) {
+		static constexpr std::string_view piece_chars = "PNBRQK";
+		auto t = std::make_unique<Table>();
+		const size_t v = name.find('v');
+
+		if (v == std::string::npos or name.size() > tb_pieces + 1 or name[0] != 'K' or v + 1 >= name.size() or name[v + 1] != 'K')
+			return;
+
+		for (size_t i = 0; i < name.size(); i++) {
+			const int type = static_cast<int>(piece_chars.find(name[i]));
+
+			if (i == v)
+				continue;
+			else if (type < 0 or (name[i] == 'K') != (i == 0 or i == v + 1))
+				return;
+			else if (name[i] != 'K')
+				t->material[i > v][type]++;
+
+			t->pieces++;
+		}
+
+		const Material& m = t->material;
+		t->name = name;
+		t->pawns = m[WHITE][PAWN] or m[BLACK][PAWN];
+		t->symmetric = m[WHITE] == m[BLACK];
+		t->lead_side = !m[BLACK][PAWN] or (m[WHITE][PAWN] and m[BLACK][PAWN] >= m[WHITE][PAWN]) ? WHITE : BLACK;
+		t->both_pawns = m[WHITE][PAWN] and m[BLACK][PAWN];
+
+		for (int side = 0; side < 2; side++)
+			for (int type = PAWN; type < KING; type++)
+				t->unique |= m[side][type] == 1;
+
+		// the same table found in another directory
+		const U64 key = materialKey(m, false), swapped_key = materialKey(m, true);
+		if (table_keys.count(key))
+			return;
+
+		table_keys[key] = table_keys[swapped_key] = t.get();
+		max_pieces = std::max(max_pieces, t->pieces);
+		tables.push_back(std::move(t));
+	}
+
+} // namespace
+
+
+void Syzygy::init(const std::string& paths) {
+	table_keys.clear();
+	tables.clear();
+	table_dirs.clear();
+	max_pieces = 0;
+
+	if (paths.empty() or paths == "<empty>")
+		return;
+
+#if defined(_WIN32)
+	constexpr char separator = ';';
+#else
+	constexpr char separator = ':';
+#endif
+
+	std::istringstream strm(paths);
+	std::string dir;
+	std::error_code ec;
+
+	while (std::getline(strm, dir, separator)) {
+		if (!std::filesystem::is_directory(dir, ec))
+			continue;
+
+		table_dirs.push_back(dir);
+
+		for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+			if (entry.path().extension() == ".rtbw")
+				addTable(entry.path().stem().string());
+		}
+	}
+
+	OS << "info string found " << tables.size() << " Syzygy tablebases up to " << max_pieces << " pieces" << std::endl;
+}
+
+bool Syzygy::probeWDL(WDLScore& wdl) {
+	bool ok = true;
+	wdl = static_cast<WDLScore>(searchWDL(WDL_LOSS, WDL_WIN, ok));
+	return ok;
+}
+
+bool Syzygy::probeDTZ(int& dtz) {
+	bool ok = true;
+	dtz = searchDTZ(ok);
+	return ok;
+}
+
+bool Syzygy::rootProbe(MoveList& root_moves) {
+	bool ok = true;
+	const int root_dtz = searchDTZ(ok), cnt50 = game_state.halfmove;
+	std::array<int, MoveList::MAX_PLAY_MOVES> dtz;
+
+	if (!ok or !root_moves.size())
+		return false;
+
+	for (size_t i = 0; i < root_moves.size(); i++) {
+		MoveScope scope(root_moves[i]);
+
+		if (isMate())
+			dtz[i] = 1;
+		else if (game_state.halfmove == 0)
+			dtz[i] = zeroingDtz(-searchWDL(WDL_LOSS, WDL_WIN, ok));
+		else {
+			dtz[i] = -searchDTZ(ok);
+			dtz[i] += dtz[i] > 0 ? 1 : dtz[i] < 0 ? -1 : 0;
+		}
+
+		if (!ok)
+			return false;
+	}
+
+	// winning - every move winning before 50 moves rule applies, or the fastest ones otherwise;
+	// losing - every move, unless 50 moves rule draw is in sight, then the longest ones; drawing - drawing moves
+	const auto first = dtz.begin(), last = dtz.begin() + root_moves.size();
+	int low = 0, high = 0;
+
+	if (root_dtz > 0) {
+		const int best = std::accumulate(first, last, INT_MAX, [](int b, int d) { return d > 0 ? std::min(b, d) : b; });
+		low = 1, high = best + cnt50 <= 99 ? 99 - cnt50 : best;
+	}
+	else if (root_dtz < 0) {
+		const int best = std::min(0, *std::min_element(first, last));
+		low = best, high = -best * 2 + cnt50 < 100 ? INT_MAX : best;
+	}
+
+	auto it = root_moves.begin();
+	for (size_t i = 0; i < root_moves.size(); i++)
+		if (dtz[i] >= low and dtz[i] <= high) *it++ = root_moves[i];
+	root_moves.it = it;
+
+	return true;
+}
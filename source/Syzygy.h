@@ -0,0 +1,50 @@
+#pragma once
+
+#include "MoveGeneration.h"
+#include <string>
+
+
+// Syzygy endgame tablebases probing - WDL tables (.rtbw) in search, DTZ tables (.rtbz) at root.
+// Tables are found by scanning SyzygyPath directories (separated by ':', or ';' on Windows) and
+// memory-mapped at first access. Table format and probing scheme follow the original Syzygy
+// generator and probing code by Ronald de Man.
+namespace Syzygy {
+
+	// win/draw/loss result from the side to move perspective - cursed wins and blessed losses
+	// are wins and losses which can't be converted (or lost) because of 50 moves rule
+	enum WDLScore {
+		WDL_LOSS = -2,
+		WDL_BLESSED_LOSS = -1,
+		WDL_DRAW = 0,
+		WDL_CURSED_WIN = 1,
+		WDL_WIN = 2
+	};
+
+	// maximum number of pieces of found tables
+	inline int max_pieces = 0;
+
+	// minimal search depth to probe tables with as many pieces as probe_limit,
+	// tables with less pieces are probed at any depth
+	inline int probe_depth = 1;
+	inline int probe_limit = 7;
+
+	// highest number of pieces, which tables are probed in search
+	inline int cardinality() noexcept {
+		return std::min(max_pieces, probe_limit);
+	}
+
+	// find available tables in given paths - '<empty>' or empty string disables probing
+	void init(const std::string& paths);
+
+	// WDL score of the current position, false if a needed table is missing or corrupted -
+	// position mustn't have castling rights
+	bool probeWDL(WDLScore& wdl);
+
+	// DTZ of the current position - distance in plies to the next capture or pawn move (zeroing move),
+	// positive for win, negative for loss, 0 for draw; above 100 for cursed wins and blessed losses
+	bool probeDTZ(int& dtz);
+
+	// keep only root moves preserving the tablebase result, return false if probing failed
+	bool rootProbe(MoveList& root_moves);
+
+} // namespace Syzygy
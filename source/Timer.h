@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <array>
+#include <algorithm>
 
 
 inline auto now() {
@@ -8,7 +10,7 @@ inline auto now() {
 	return clock.now();
 }
 
-inline constexpr auto sinceStart_ms(std::chrono::system_clock::time_point start) {
+inline auto sinceStart_ms(std::chrono::system_clock::time_point start) {
 	return std::chrono::duration_cast<std::chrono::milliseconds>(now() - start).count();
 }
 
@@ -42,19 +44,36 @@ inline constexpr int operator "" _ms(const ULL a) noexcept {
 }
 
 struct Time {
+	// hard limit - search is aborted immediately once this amount of time passes
 	inline bool checkTimeLeft() noexcept {
-		return sinceStart_ms(start) < this_move;
+		return sinceStart_ms(start) < max_move;
+	}
+
+	// hard limits of the search - time or fixed node budget is exhausted
+	inline bool hardLimitReached(const ULL nodes) noexcept {
+		return (is_time and !checkTimeLeft()) or (max_nodes and nodes >= max_nodes);
+	}
+
+	// soft limit - decide whether there is enough time to start next iteration,
+	// assuming next iteration takes about 2.5x time of all the previous ones
+	inline bool softLimitReached() noexcept {
+		return is_time and 5 * sinceStart_ms(start) / 2 > this_move * stability_scale / 100;
 	}
 
 	// fixed amount of given time - zero fixed time means no time control
 	inline void setFixedTime(int fixed_time) noexcept {
 		is_time = static_cast<bool>(fixed_time), stop = false;
-		this_move = fixed_time;
+		is_managed = false;
+		max_nodes = 0;
+		this_move = max_move = fixed_time;
+		resetStability();
 	}
 
-	// calculate time for single move
+	// calculate soft and hard time limits for single move
 	void calcMoveTime(int time_left, int time_inc) noexcept {
 		is_time = true, stop = false;
+		is_managed = true;
+		max_nodes = 0;
 
 		left = time_left;
 		inc = time_inc;
@@ -65,10 +84,46 @@ struct Time {
 
 		if (this_move < 0_ms)
 			this_move = 5_ms;
+
+		// never let single move consume more than a fifth of the remaining clock
+		max_move = std::min(4 * this_move, std::max(left / 5, this_move));
+		resetStability();
+	}
+
+	// adjust soft limit after finished iteration based on root best move stability 
+	// and score fluctuation - spend more time when search is unsure, cut it short when 
+	// the same move has been found as the best for several depths
+	void updateStability(bool best_changed, int score_drop) noexcept {
+		static constexpr std::array<int, 5> stable_scale = { 150, 115, 100, 85, 70 };
+
+		if (!is_managed)
+			return;
+
+		stable_depths = best_changed ? 0 : std::min(stable_depths + 1, static_cast<int>(stable_scale.size()) - 1);
+		stability_scale = stable_scale[stable_depths];
+
+		// score drop bonus in percents, max. 50% of soft limit 
+		if (score_drop > 0)
+			stability_scale += std::min(score_drop, 100) / 2;
+
+		// soft limit can't exceed hard limit
+		stability_scale = std::min(stability_scale, 100 * max_move / std::max(this_move, 1));
+	}
+
+	// fixed number of nodes - zero means no node limit, has to be set after the time limits
+	inline void setNodeLimit(const ULL limit) noexcept {
+		max_nodes = limit;
+	}
+
+	inline void resetStability() noexcept {
+		stable_depths = 0;
+		stability_scale = 100;
 	}
 
-	bool is_time, stop;
+	bool is_time, stop, is_managed;
 	int left, inc,
-		this_move;
+		this_move, max_move,
+		stable_depths, stability_scale;
+	ULL max_nodes;
 	decltype(now()) start;
 };
@@ -0,0 +1,352 @@
+#include "Tuner.h"
+#include "Batch.h"
+#include "Evaluation.h"
+#include "BitBoardsSet.h"
+#include "UCI.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+	using namespace Eval;
+
+	// position of the data set - game result from white's point of view, part of the score not covered
+	// by parameters and range of its sparse coefficients in the common terms vector
+	struct Entry {
+		float result, rest;
+		uint32_t begin, end;
+	};
+
+	struct Term {
+		uint16_t index;
+		float coef;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<Term> terms;
+
+	using Vector = std::vector<double>;
+
+	// scalar weights - parameter index, compiled in value and name in Value namespace
+	struct Scalar {
+		int index, value;
+		const char* name;
+	};
+
+	static constexpr Scalar scalars[] = {
+		{ Params::PAWN_ISLAND, Value::PAWN_ISLAND, "PAWN_ISLAND" },
+		{ Params::BACKWARD_PAWN, Value::BACKWARD_PAWN, "BACKWARD_PAWN" },
+		{ Params::DOUBLED_PAWN, Value::DOUBLED_PAWN, "DOUBLED_PAWN" },
+		{ Params::PROTECTED_PAWN, Value::PROTECTED_PAWN, "PROTECTED_PAWN" },
+		{ Params::PAWN_CHAIN, Value::PAWN_CHAIN, "PAWN_CHAIN" },
+		{ Params::ISOLATED_PAWN, Value::ISOLATED_PAWN, "ISOLATED_PAWN" },
+		{ Params::HALF_ISOLATED_PAWN, Value::HALF_ISOLATED_PAWN, "HALF_ISOLATED_PAWN" },
+		{ Params::OVERLY_ADVANCED_PAWN, Value::OVERLY_ADVANCED_PAWN, "OVERLY_ADVANCED_PAWN" },
+		{ Params::NO_PAWNS, Value::NO_PAWNS, "NO_PAWNS" },
+		{ Params::FULL_PAWN_SHIELD, Value::FULL_PAWN_SHIELD, "FULL_PAWN_SHIELD" },
+		{ Params::PARTIAL_PAWN_SHIELD, Value::PARTIAL_PAWN_SHIELD, "PARTIAL_PAWN_SHIELD" },
+		{ Params::OPEN_KING_FILE, Value::OPEN_KING_FILE, "OPEN_KING_FILE" },
+		{ Params::UNDEFENDED_MINOR, Value::UNDEFENDED_MINOR, "UNDEFENDED_MINOR" },
+		{ Params::BISHOP_PAIR, Value::BISHOP_PAIR, "BISHOP_PAIR" },
+		{ Params::ROOK_OPEN_FILE, Value::ROOK_OPEN_FILE, "ROOK_OPEN_FILE" },
+		{ Params::ROOK_QUEEN_FILE, Value::ROOK_QUEEN_FILE, "ROOK_QUEEN_FILE" },
+		{ Params::TARRASCH_ROOK, Value::TARRASCH_ROOK, "TARRASCH_ROOK" },
+		{ Params::CASTLE_BONUS, Value::CASTLE_BONUS, "CASTLE_BONUS" },
+		{ Params::ENDGAME_PAWN_ATTACK, Value::ENDGAME_PAWN_ATTACK, "ENDGAME_PAWN_ATTACK" },
+		{ Params::PAWN_ATTACK, Value::PAWN_ATTACK, "PAWN_ATTACK" },
+		{ Params::MINOR_ATTACK, Value::MINOR_ATTACK, "MINOR_ATTACK" },
+		{ Params::ROOK_ATTACK, Value::ROOK_ATTACK, "ROOK_ATTACK" },
+		{ Params::QUEEN_ATTACK, Value::QUEEN_ATTACK, "QUEEN_ATTACK" },
+	};
+
+	static constexpr const char* material_names[] = { "PAWN_VALUE", "KNIGHT_VALUE", "BISHOP_VALUE", "ROOK_VALUE", "QUEEN_VALUE" };
+	static constexpr const char* piece_names[] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+
+	// current values of the parameters, as compiled in
+	Vector defaults() {
+		Vector p(Params::COUNT, 0.);
+
+		for (int pc = PAWN; pc <= QUEEN; pc++)
+			p[Params::MATERIAL + pc] = Value::piece_material[pc];
+
+		for (int pc = PAWN; pc <= KING; pc++)
+			for (int sq = 0; sq < 64; sq++) {
+				p[Params::PST_MG + 64 * pc + sq] = Value::position_score[gState::MIDDLEGAME][pc][sq];
+				p[Params::PST_EG + 64 * pc + sq] = Value::position_score[gState::ENDGAME][pc][sq];
+			}
+
+		std::copy(Value::passed_score.begin(), Value::passed_score.end(), p.begin() + Params::PASSED);
+		std::copy(Value::outpos_score.begin(), Value::outpos_score.end(), p.begin() + Params::OUTPOST);
+		std::copy(Value::attack_count_weight.begin(), Value::attack_count_weight.end(), p.begin() + Params::KING_ATTACK);
+
+		for (const auto& s : scalars)
+			p[s.index] = s.value;
+
+		return p;
+	}
+
+	// game result of labelled line, negative if there is none - bracket label is cut off the line
+	double parseLabel(std::string& line, Batch::Position& pos) {
+		const size_t bracket = line.find('[');
+		double result = -1.;
+
+		if (bracket != std::string::npos) {
+			result = std::strtod(line.c_str() + bracket + 1, nullptr);
+			line.erase(bracket);
+		}
+
+		if (!Batch::parseEPD(line, pos))
+			return -1.;
+
+		for (const auto& [opcode, operand] : pos.ops) {
+			if (operand == "1-0") result = 1.;
+			else if (operand == "0-1") result = 0.;
+			else if (operand == "1/2-1/2") result = .5;
+		}
+
+		return result <= 1. ? result : -1.;
+	}
+
+	// trace every labelled position of the file - positions scored only by bitbases have no coefficients and are skipped
+	void load(std::istream& src, const Vector& params) {
+		Params::Coefficients coef;
+		Batch::Position pos;
+		std::string line;
+
+		entries.clear();
+		terms.clear();
+
+		while (std::getline(src, line)) {
+			const double result = parseLabel(line, pos);
+			if (result < 0.) continue;
+
+			BBs.parseFEN(pos.fen);
+			double rest = Params::trace(coef);
+			const uint32_t begin = static_cast<uint32_t>(terms.size());
+
+			for (int i = 0; i < Params::COUNT; i++) {
+				if (coef[i] == 0.) continue;
+				terms.push_back({ static_cast<uint16_t>(i), static_cast<float>(coef[i]) });
+				rest -= coef[i] * params[i];
+			}
+
+			if (terms.size() != begin)
+				entries.push_back({ static_cast<float>(result), static_cast<float>(rest), begin, static_cast<uint32_t>(terms.size()) });
+		}
+	}
+
+	inline double sigmoid(const double k, const double score) {
+		return 1. / (1. + std::pow(10., -k * score / 400.));
+	}
+
+	inline double linearScore(const Entry& e, const Vector& params) {
+		double score = e.rest;
+		for (uint32_t i = e.begin; i < e.end; i++)
+			score += terms[i].coef * params[terms[i].index];
+		return score;
+	}
+
+	// run job(begin, end, thread) on equal slices of the data set
+	template <typename F>
+	void parallelFor(const int threads_num, F&& job) {
+		std::vector<std::thread> pool;
+		const size_t slice = (entries.size() + threads_num - 1) / threads_num;
+
+		for (int t = 0; t < threads_num; t++) {
+			const size_t begin = std::min(entries.size(), t * slice), end = std::min(entries.size(), begin + slice);
+			pool.emplace_back(job, begin, end, t);
+		}
+
+		for (auto& th : pool)
+			th.join();
+	}
+
+	// mean squared error of the data set
+	double loss(const double k, const Vector& params, const int threads_num) {
+		Vector sums(threads_num, 0.);
+
+		parallelFor(threads_num, [&](const size_t begin, const size_t end, const int t) {
+			double sum = 0.;
+			for (size_t i = begin; i < end; i++) {
+				const double r = entries[i].result - sigmoid(k, linearScore(entries[i], params));
+				sum += r * r;
+			}
+			sums[t] = sum;
+		});
+
+		return std::accumulate(sums.begin(), sums.end(), 0.) / entries.size();
+	}
+
+	// gradient of mean squared error, every thread sums into its own vector - returns the error as well
+	double gradient(const double k, const Vector& params, const int threads_num, Vector& grad) {
+		std::vector<Vector> partial(threads_num, Vector(Params::COUNT, 0.));
+		Vector sums(threads_num, 0.);
+		const double scale = k * std::log(10.) / 400.;
+
+		parallelFor(threads_num, [&](const size_t begin, const size_t end, const int t) {
+			Vector& g = partial[t];
+			double sum = 0.;
+
+			for (size_t i = begin; i < end; i++) {
+				const Entry& e = entries[i];
+				const double s = sigmoid(k, linearScore(e, params)), r = e.result - s;
+				// d/dp (result - sigmoid)^2 = -2 * (result - sigmoid) * sigmoid' * coefficient
+				const double d = -2. * r * s * (1. - s) * scale;
+
+				sum += r * r;
+				for (uint32_t j = e.begin; j < e.end; j++)
+					g[terms[j].index] += d * terms[j].coef;
+			}
+
+			sums[t] = sum;
+		});
+
+		std::fill(grad.begin(), grad.end(), 0.);
+		for (const auto& g : partial)
+			for (int i = 0; i < Params::COUNT; i++)
+				grad[i] += g[i] / entries.size();
+
+		return std::accumulate(sums.begin(), sums.end(), 0.) / entries.size();
+	}
+
+	// scaling constant minimizing error of current parameters - golden section search
+	double fitK(const Vector& params, const int threads_num) {
+		static constexpr double ratio = 0.6180339887;
+		double lo = 0.05, hi = 4.;
+
+		for (int i = 0; i < 40; i++) {
+			const double k1 = hi - ratio * (hi - lo), k2 = lo + ratio * (hi - lo);
+			if (loss(k1, params, threads_num) < loss(k2, params, threads_num))
+				hi = k2;
+			else
+				lo = k1;
+		}
+
+		return (lo + hi) / 2.;
+	}
+
+	void printTable(std::ostream& out, const std::string& decl, const Vector& params, const int first, const int size) {
+		out << "\t\tconstexpr " << decl << " = {\n";
+
+		for (int i = 0; i < size; i++) {
+			if (i % 8 == 0) out << "\t\t\t";
+			out << std::setw(4) << std::lround(params[first + i]) << (i % 8 == 7 or i == size - 1 ? ",\n" : ", ");
+		}
+
+		out << "\t\t};\n\n";
+	}
+
+	// tuned parameters as the source of Value namespace
+	void printParams(std::ostream& out, const Vector& params) {
+		out << "\t\t// material - PieceValue\n";
+		for (int pc = PAWN; pc <= QUEEN; pc++)
+			out << "\t\t\t" << material_names[pc] << " = " << std::lround(params[Params::MATERIAL + pc]) << ",\n";
+		out << '\n';
+
+		for (int pc = PAWN; pc <= KING; pc++) {
+			printTable(out, std::string("posScoreTab ") + piece_names[pc] + "_score", params, Params::PST_MG + 64 * pc, 64);
+			printTable(out, std::string("posScoreTab late_") + piece_names[pc] + "_score", params, Params::PST_EG + 64 * pc, 64);
+		}
+
+		printTable(out, "passedPawnTab passed_score", params, Params::PASSED, 7);
+		printTable(out, "std::array<int, 11> attack_count_weight", params, Params::KING_ATTACK, 11);
+		printTable(out, "posScoreTab outpos_score", params, Params::OUTPOST, 64);
+
+		out << "\t\t// weights - pawnStructureWeight, pieceWeight and connectivityProtectionWeight\n";
+		for (const auto& s : scalars)
+			out << "\t\t\t" << s.name << " = " << std::lround(params[s.index]) << ",\n";
+	}
+
+} // namespace
+
+
+void Tuner::run(std::istream& args) {
+	std::string path, output, key;
+	int epochs = 1000, report = 50, threads_num = std::max(1u, std::thread::hardware_concurrency());
+	double rate = 1., k = 0.;
+
+	if (!(args >> path)) {
+		OS << "tune <file> [epochs N] [threads N] [rate F] [k F] [report N] [output <file>]\n";
+		return;
+	}
+
+	while (args >> key) {
+		if (key == "epochs")       args >> epochs;
+		else if (key == "threads") args >> threads_num;
+		else if (key == "rate")    args >> rate;
+		else if (key == "k")       args >> k;
+		else if (key == "report")  args >> report;
+		else if (key == "output")  args >> output;
+	}
+
+	std::ifstream src(path);
+
+	if (!src.is_open()) {
+		OS << "info string tuning file '" << path << "' not found\n";
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto elapsed = [&start]() {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	threads_num = std::max(1, threads_num);
+	Vector params = defaults(), grad(Params::COUNT), m(Params::COUNT, 0.), v(Params::COUNT, 0.);
+
+	load(src, params);
+	BBs.parseFEN(BitBoardsSet::start_pos);
+
+	if (entries.empty()) {
+		OS << "info string no labelled positions in '" << path << "'\n";
+		return;
+	}
+
+	OS << "positions " << entries.size() << " terms " << terms.size() << " time " << elapsed() << std::endl;
+
+	if (k <= 0.)
+		k = fitK(params, threads_num);
+
+	OS << "k " << k << " loss " << loss(k, params, threads_num) << std::endl;
+
+	// adam optimizer
+	static constexpr double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+	double beta1_pow = 1., beta2_pow = 1.;
+
+	for (int epoch = 1; epoch <= epochs; epoch++) {
+		const double error = gradient(k, params, threads_num, grad);
+		beta1_pow *= beta1, beta2_pow *= beta2;
+
+		for (int i = 0; i < Params::COUNT; i++) {
+			m[i] = beta1 * m[i] + (1. - beta1) * grad[i];
+			v[i] = beta2 * v[i] + (1. - beta2) * grad[i] * grad[i];
+			params[i] -= rate * (m[i] / (1. - beta1_pow)) / (std::sqrt(v[i] / (1. - beta2_pow)) + epsilon);
+		}
+
+		if (epoch % report == 0 or epoch == epochs)
+			OS << "epoch " << epoch << " loss " << error << " time " << elapsed() << std::endl;
+	}
+
+	OS << "final loss " << loss(k, params, threads_num) << std::endl;
+
+	if (!output.empty()) {
+		std::ofstream out(output);
+		printParams(out, params);
+		OS << "info string tuned parameters written to '" << output << "'\n";
+	}
+	else
+		printParams(OS, params);
+
+	entries.clear();
+	entries.shrink_to_fit();
+	terms.clear();
+	terms.shrink_to_fit();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <istream>
+
+
+// texel tuning of evaluation parameters - every position of a labelled data set is evaluated once with
+// a linear trace, which gives coefficients of the parameters in the score. Sigmoid loss and its gradient
+// are then computed from cached traces alone, in parallel threads, and parameters are optimized with Adam
+namespace Tuner {
+
+	// 'tune <file> [epochs N] [threads N] [rate F] [k F] [report N] [output <file>]' - positions are FEN/EPD
+	// lines labelled with game result as 'c9 "1-0";' operation or '[1.0]' suffix (white's point of view),
+	// sigmoid scaling constant is fitted to the data set unless given, tuned tables are written as C++ source
+	void run(std::istream& args);
+
+} // namespace Tuner
@@ -6,12 +6,27 @@
 #include "Zobrist.h"
 #include "Evaluation.h"
 #include "MoveOrder.h"
+#include "Syzygy.h"
+#include "Book.h"
+#include "Batch.h"
+#include "SelfPlay.h"
+#include "Tuner.h"
 #include <iostream>
 #include <string>
 
 
 UCI::UCI() 
-	: o_stream(&std::cout), i_stream(&std::cin) {
+	: o_stream(&std::cout), i_stream(&std::cin),
+	options{
+		{ "Hash", std::to_string(TranspositionTable::default_MB_size / 1_MB) },
+		{ "SearchStats", "false" },
+		{ "SyzygyPath", "<empty>" },
+		{ "SyzygyProbeDepth", "1" },
+		{ "SyzygyProbeLimit", "7" },
+		{ "OwnBook", "false" },
+		{ "BookFile", "<empty>" },
+		{ "BookBestMove", "false" }
+	} {
 	std::ios_base::sync_with_stdio(false);
 }
 
@@ -20,6 +35,13 @@ inline void parseUCI() {
 	OS << UCI::engine_name << '\n'
 		<< UCI::author << '\n'
 		<< TranspositionTable::hashInfo() << '\n'
+		<< "option name SearchStats type check default false\n"
+		<< "option name SyzygyPath type string default <empty>\n"
+		<< "option name SyzygyProbeDepth type spin default 1 min 1 max 100\n"
+		<< "option name SyzygyProbeLimit type spin default 7 min 0 max 7\n"
+		<< "option name OwnBook type check default false\n"
+		<< "option name BookFile type string default <empty>\n"
+		<< "option name BookBestMove type check default false\n"
 		<< "uciok\n";
 }
 
@@ -30,6 +52,17 @@ void parseGo(std::istringstream& strm) {
 
 	strm >> std::skipws >> com;
 
+	// position in book - answer instantly without search
+	if (Book::enabled and com != "perft") {
+		const MoveItem::iMove book_move = Book::probe();
+
+		if (book_move != MoveItem::iMove::no_move) {
+			OS << "bestmove ";
+			book_move.print() << '\n';
+			return;
+		}
+	}
+
 	if (com == "depth") {
 		strm >> std::skipws >> depth;
 		m_search.time_data.setFixedTime(0);
@@ -52,6 +85,14 @@ void parseGo(std::istringstream& strm) {
 		m_search.time_data.setFixedTime(mtime);
 		m_search.bestMove(mSearch::max_depth);
 	}
+	else if (com == "nodes") {
+		static ULL max_nodes;
+		strm >> std::skipws >> max_nodes;
+
+		m_search.time_data.setFixedTime(0);
+		m_search.time_data.setNodeLimit(max_nodes);
+		m_search.bestMove(mSearch::max_depth);
+	}
 	else if (com == "perft") {
 		strm >> std::skipws >> depth;
 		MoveGenerator::Analisis::perftDriver(depth);
@@ -67,6 +108,10 @@ void UCI::parsePosition(std::istringstream& strm) {
 
 	m_search.prev_move = MoveItem::iMove::no_move;
 
+	// new game history, unless moves are played in the current position
+	if (com == "startpos" or com == "fen")
+		rep_tt.clear();
+
 	// set starting or given fen
 	if (com == "startpos") {
 		BBs.parseFEN(BitBoardsSet::start_pos);
@@ -97,8 +142,6 @@ void UCI::parsePosition(std::istringstream& strm) {
 	if (com != "moves")
 		return;
 
-	rep_tt.clear();
-
 	MoveItem::iMove casted;
 	MoveList ml;
 
@@ -113,9 +156,10 @@ void UCI::parsePosition(std::istringstream& strm) {
 
 		for (const auto& move : ml) {
 			if (casted == move) {
+				// positions are registered before the move is made, as in search - current one is never in the table
+				rep_tt.posRegister();
 				MovePerform::makeMove(move);
 				illegal = false;
-				rep_tt.posRegister();
 				m_search.prev_move = move;
 				break;
 			}
@@ -133,35 +177,72 @@ inline void newGame() {
 	tt.clear();
 	rep_tt.clear();
 	m_search.move_order.clearCountermove();
+	m_search.move_order.clearHistory();
 	BBs.parseFEN(BitBoardsSet::start_pos);
 }
 
 
-void setOption(std::istringstream& strm) {
-	std::string com;
-
-	strm >> std::skipws >> com >> std::skipws >> com;
+void UCI::setOption(std::istringstream& strm) {
+	std::string name, value;
+
+	// 'name <id> value <x>' - path values may contain spaces, so take the rest of the line
+	strm >> std::skipws >> name >> std::skipws >> name >> std::skipws >> value;
+	value.clear();
+	std::getline(strm >> std::ws, value);
+	value.erase(value.find_last_not_of(" \t\r") + 1);
+
+	if (name == "Hash")
+		tt.setSize(std::stoi(value));
+	else if (name == "SearchStats")
+		m_search.stats_info = (value == "true");
+	else if (name == "SyzygyPath")
+		Syzygy::init(value);
+	else if (name == "OwnBook")
+		Book::enabled = (value == "true");
+	else if (name == "BookFile")
+		Book::open(value);
+	else if (name == "BookBestMove")
+		Book::best_move = (value == "true");
+	else if (name == "SyzygyProbeDepth")
+		Syzygy::probe_depth = std::stoi(value);
+	else if (name == "SyzygyProbeLimit")
+		Syzygy::probe_limit = std::stoi(value);
+	else return;
+
+	options[name] = value;
+}
 
-	if (com == "Hash") {
-		strm >> std::skipws >> com >> std::skipws >> com;
-		tt.setSize(std::stoi(com));
-	}
+std::string UCI::getOption(const std::string& name) const {
+	const auto it = options.find(name);
+	return it != options.end() ? it->second : std::string();
 }
 
 
 #if defined(__DEBUG__)
 void seePrint(std::istringstream& strm) {
-	std::string sq_str;
-	strm >> std::skipws >> sq_str;
-	int sq = (sq_str[1] - '1') * 8 + (sq_str[0] - 'a');
-	OS << Order::see(sq) << '\n';
+	std::string move_str;
+	strm >> std::skipws >> move_str;
+
+	MoveItem::iMove casted;
+	MoveList ml;
+	casted.constructMove(move_str);
+	MoveGenerator::generateLegalMoves<MoveGenerator::LEGAL>(ml);
+
+	for (const auto& move : ml) {
+		if (casted == move) {
+			OS << mOrder::see(move) << '\n';
+			return;
+		}
+	}
+
+	OS << "illegal move\n";
 }
 
 void evalInfo() {
 	OS << "white material: " << game_state.material[0] << '\n'
 		<< "black material: " << game_state.material[1] << '\n'
 		<< "pawn endgame: " << game_state.isPawnEndgame() << '\n'
-		<< Eval::evaluate(Search::low_bound, Search::high_bound) << "\n\n";
+		<< Eval::evaluate(mSearch::low_bound, mSearch::high_bound) << "\n\n";
 }
 #endif
 
@@ -191,12 +272,21 @@ void UCI::goLoop(int argc, char* argv[]) {
 		else if (token == "go")         parseGo(strm);
 		else if (token == "setoption")  setOption(strm);
 		else if (token == "print")      BBs.printBoard();
-		else if (token == "benchmark")  bench.start();
+		else if (token == "bench")      bench.run(strm);
+		else if (token == "batch")      Batch::run(strm);
+		else if (token == "epdtest")    Batch::epdTest(strm);
+		else if (token == "selfplay")   SelfPlay::run(strm);
+		else if (token == "tune")       Tuner::run(strm);
+		else if (token == "evaltrace")  Eval::printTrace(OS);
+		else if (token == "kpktest")    Eval::kpkTest(OS);
+		else if (token == "benchmark")  strm >> std::skipws >> token ? bench.start(token) : bench.start();
 		else if (token == "hashinfo")   OS << tt.currSizeInfo() << '\n';
+		else if (token == "searchstats") OS << m_search.stats.summary() << '\n';
 #if defined(__DEBUG__)
 		else if (token == "hashkey")    OS << hash.key << '\n';
 		else if (token == "eval")       evalInfo();
 		else if (token == "see")        seePrint(strm);
+		else if (token == "repetition") OS << rep_tt.isRepetition() << '\n';
 #endif
 	} while (line != "quit");
 }
\ No newline at end of file
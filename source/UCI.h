@@ -1,13 +1,20 @@
 #pragma once
 
 #include <sstream>
+#include <string>
+#include <map>
 
 
 class UCI {
 public:
 	UCI();
 	void parsePosition(std::istringstream&);
+	void setOption(std::istringstream&);
 	void goLoop(int argc = 1, char* argv[] = nullptr);
+
+	// value of an option given to the last 'setoption' command, default one if it wasn't set yet
+	std::string getOption(const std::string& name) const;
+
 	std::istream* i_stream;
 	std::ostream* o_stream;
 
@@ -15,6 +22,10 @@ public:
 		engine_name = "id name Austerlitz v1.4.8",
 		author = "id author Szymon Belz",
 		introduction = "Polish chess engine, Austerlitz v1.4.8 - by Szymon Belz\n";
+
+private:
+	// current values of all the options, by option name
+	std::map<std::string, std::string> options;
 };
 
 extern UCI UCI_o;
@@ -13,6 +13,14 @@ struct Zobrist {
 	// calculate Zobrist key for current position
 	void generateKey();
 
+	// key of current position in Polyglot opening books format, computed from scratch
+	static U64 polyglotKey();
+
+	// key modifier of excluded-move searches, so they don't share tt entries with normal searches
+	static inline U64 exclusionKey(const MoveItem::iMove move) noexcept {
+		return (move.raw() + 1ULL) * 0x9E3779B97F4A7C15ULL;
+	}
+
 	// 12 - number of all pieces (nWhitePawn..nBlackKing)
 	cexpr::CexprArr<true, U64, 12, 64> piece_keys;
 	cexpr::CexprArr<false, U64, 16> castle_keys;
@@ -28,7 +36,9 @@ extern Zobrist hash;
 
 // single entry in hash table structure
 struct HashEntry {
-	static constexpr int no_score = std::numeric_limits<int>::min();
+	static constexpr int no_score = std::numeric_limits<int>::min(),
+		// static evaluation is stored in 16 bits, no_eval marks nodes in check or not evaluated yet
+		no_eval = std::numeric_limits<int16_t>::min();
 
 	// hashing flags
 	enum class Flag : uint8_t {
@@ -42,6 +52,7 @@ struct HashEntry {
 	U64 zobrist;
 	uint8_t depth, age;
 	Flag flag;
+	int16_t eval;
 	int score;
 	MoveItem::iMove move;
 };
@@ -59,7 +70,7 @@ public:
 
 	static constexpr HashEntry empty_entry = {
 		0, 0, 0, 
-		HashEntry::Flag::HASH_EXACT, 
+		HashEntry::Flag::HASH_EXACT, HashEntry::no_eval,
 		HashEntry::no_score, MoveItem::iMove::no_move 
 	};
 	
@@ -69,7 +80,10 @@ public:
 	};
 
 	int read(int alpha, int beta, int g_depth, int ply);
-	void write(int g_depth, int g_score, HashEntry::Flag g_flag, int ply, MoveItem::iMove g_move);
+	void write(
+		int g_depth, int g_score, HashEntry::Flag g_flag, int ply, 
+		MoveItem::iMove g_move, int g_eval = HashEntry::no_eval
+	);
 
 	// get hash move from tt entry of current hashkey
 	inline MoveItem::iMove hashMove() noexcept {
@@ -77,6 +91,18 @@ public:
 		return (entry.zobrist == hash.key) ? entry.move : MoveItem::iMove::no_move;
 	};
 
+	// get entry of current position, nullptr if there is none
+	inline const HashEntry* probe() const noexcept {
+		const HashEntry& entry = htab[hash.key % hash_size];
+		return (entry.zobrist == hash.key) ? &entry : nullptr;
+	}
+
+	// get cached static evaluation of current position, no_eval if there is none
+	inline int staticEval() noexcept {
+		const HashEntry& entry = htab[hash.key % hash_size];
+		return (entry.zobrist == hash.key) ? entry.eval : HashEntry::no_eval;
+	}
+
 	void recreatePV(int g_depth, MoveItem::iMove best, MoveItem::iMove& ponder);
 	void setSize(size_t g_size);
 
@@ -92,6 +118,8 @@ public:
 			+ " max " + std::to_string(max_MB_size / 1_MB);
 	}
 
+	inline size_t sizeMB() const noexcept { return memory_MB_size / 1_MB; }
+
 	inline std::string currSizeInfo() {
 		return "hash size " + std::to_string(memory_MB_size / 1_MB)
 			+ "MB entries number " + std::to_string(hash_size);
@@ -120,6 +148,7 @@ public:
 	RepetitionTable() = default;
 
 	bool isRepetition();
+	bool isUpcomingRepetition(int ply);
 	void posRegister() noexcept;
 
 	inline void clear() noexcept { count = 0; }
@@ -136,9 +165,52 @@ inline void RepetitionTable::posRegister() noexcept {
 	tab[count++] = hash.key;
 }
 
-
+// only positions since last irreversible move with the same side to move can repeat,
+// so scan reversible window only, skipping positions of the opponent - positions are registered
+// before a move is made (in search, position command and self-play alike), so the current one isn't in the table
 inline bool RepetitionTable::isRepetition() {
-	for (int i = count - 1; i >= 0; i--)
-		if (tab[i] == hash.key) return true;
+	const int end = std::min(game_state.halfmove, count);
+
+	for (int i = 4; i <= end; i += 2)
+		if (tab[count - i] == hash.key) return true;
 	return false;
-}
\ No newline at end of file
+}
+
+
+// cuckoo tables of Zobrist keys differences of all the reversible piece moves, 
+// used to detect whether side to move can repeat a position with a single move
+namespace Cuckoo {
+	constexpr int size = 0x2000;
+
+	// two hash functions of cuckoo hashing - Zobrist keys are sparse, 
+	// so mix all the key bits instead of taking raw bit slices
+	inline constexpr int h1(U64 key) noexcept { return static_cast<int>((key * 0x9E3779B97F4A7C15) >> 51); }
+	inline constexpr int h2(U64 key) noexcept { return static_cast<int>((key * 0xC2B2AE3D27D4EB4F) >> 51); }
+
+	extern std::array<U64, size> keys;
+	extern std::array<std::pair<int, int>, size> moves;
+}
+
+namespace InitState {
+	// fill cuckoo tables - have to be called after Zobrist keys initialization
+	void initCuckooTables();
+}
+
+// detect position, where side to move is able to repeat earlier position with a reversible move - 
+// that allows to claim a draw one ply earlier than isRepetition() does
+inline bool RepetitionTable::isUpcomingRepetition(int ply) {
+	const int end = std::min(game_state.halfmove, count);
+	U64 move_key;
+	int j;
+
+	// consider only cycles lying entirely inside search tree
+	for (int i = 3; i <= end and i < ply; i += 2) {
+		move_key = hash.key ^ tab[count - i];
+
+		if ((Cuckoo::keys[j = Cuckoo::h1(move_key)] == move_key or Cuckoo::keys[j = Cuckoo::h2(move_key)] == move_key)
+			and !(inBetween(Cuckoo::moves[j].first, Cuckoo::moves[j].second) & BBs[nOccupied]))
+			return true;
+	}
+
+	return false;
+}